@@ -0,0 +1,34 @@
+/**
+ * @file   bufreader.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for buffered socket reader declarations
+ *
+ *
+ */
+
+#ifndef RINOO_NET_BUFREADER_H_
+#define RINOO_NET_BUFREADER_H_
+
+#define RN_BUFREADER_SIZE	(16 * 1024)
+
+typedef struct rn_bufreader_s {
+	char *buf;
+	size_t size;
+	size_t start;
+	size_t end;
+	rn_socket_t *socket;
+} rn_bufreader_t;
+
+int rn_bufreader(rn_bufreader_t *reader, rn_socket_t *socket, size_t size);
+void rn_bufreader_destroy(rn_bufreader_t *reader);
+size_t rn_bufreader_buffered(rn_bufreader_t *reader);
+ssize_t rn_bufreader_fill(rn_bufreader_t *reader);
+ssize_t rn_bufreader_peek(rn_bufreader_t *reader, size_t count, char **data);
+void rn_bufreader_consume(rn_bufreader_t *reader, size_t count);
+ssize_t rn_bufreader_read_until(rn_bufreader_t *reader, const char *delim, size_t maxsize, char **data);
+ssize_t rn_bufreader_readline(rn_bufreader_t *reader, size_t maxsize, char **line);
+ssize_t rn_bufreader_read_exact(rn_bufreader_t *reader, void *buf, size_t count);
+
+#endif /* !RINOO_NET_BUFREADER_H_ */
@@ -0,0 +1,37 @@
+/**
+ * @file   bufwriter.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for buffered socket writer declarations
+ *
+ *
+ */
+
+#ifndef RINOO_NET_BUFWRITER_H_
+#define RINOO_NET_BUFWRITER_H_
+
+#define RN_BUFWRITER_THRESHOLD	(16 * 1024)
+#define RN_BUFWRITER_HIGHWATER	(256 * 1024)
+
+typedef struct rn_bufwriter_s {
+	bool flushing;
+	char *buf;
+	size_t len;
+	size_t msize;
+	size_t threshold;
+	size_t highwater;
+	rn_task_t *task;
+	rn_socket_t *socket;
+	rn_task_hook_t hook;
+} rn_bufwriter_t;
+
+int rn_bufwriter(rn_bufwriter_t *writer, rn_socket_t *socket, size_t threshold, size_t highwater);
+void rn_bufwriter_destroy(rn_bufwriter_t *writer);
+size_t rn_bufwriter_pending(rn_bufwriter_t *writer);
+ssize_t rn_bufwriter_write(rn_bufwriter_t *writer, const void *buf, size_t count);
+ssize_t rn_bufwriter_writeb(rn_bufwriter_t *writer, rn_buffer_t *buffer);
+ssize_t rn_bufwriter_writestr(rn_bufwriter_t *writer, const char *str);
+int rn_bufwriter_flush(rn_bufwriter_t *writer);
+
+#endif /* !RINOO_NET_BUFWRITER_H_ */
@@ -0,0 +1,64 @@
+/**
+ * @file   dispatcher.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for connection dispatcher declarations.
+ *
+ *
+ */
+
+#ifndef RINOO_NET_DISPATCHER_H_
+#define RINOO_NET_DISPATCHER_H_
+
+/* Defined below */
+struct rn_dispatcher_s;
+
+typedef enum rn_dispatch_policy_e {
+	RN_DISPATCH_RR = 0,
+	RN_DISPATCH_LEASTCONN,
+	RN_DISPATCH_LEASTLAG,
+	RN_DISPATCH_HASH,
+} rn_dispatch_policy_t;
+
+typedef struct rn_dispatch_gauges_s {
+	uint32_t conns;
+	uint32_t lag;
+	uint64_t dispatched;
+} rn_dispatch_gauges_t;
+
+typedef struct rn_dispatch_worker_s {
+	bool running;
+	rn_fd_t *event;
+	rn_sched_t *sched;
+	rn_list_t queue;
+	pthread_mutex_t mutex;
+	rn_dispatch_gauges_t gauges;
+	struct rn_dispatcher_s *dispatcher;
+} rn_dispatch_worker_t;
+
+typedef struct rn_dispatch_job_s {
+	rn_socket_t *socket;
+	rn_list_node_t lnode;
+	rn_dispatch_worker_t *worker;
+} rn_dispatch_job_t;
+
+typedef struct rn_dispatcher_s {
+	int refs;
+	int count;
+	uint32_t next;
+	void *arg;
+	rn_dispatch_policy_t policy;
+	rn_dispatch_worker_t *workers;
+	void (*handler)(rn_socket_t *socket, void *arg);
+	int (*select)(struct rn_dispatcher_s *dispatcher, const rn_addr_t *from);
+} rn_dispatcher_t;
+
+rn_dispatcher_t *rn_dispatcher(rn_sched_t *sched, rn_dispatch_policy_t policy, void (*handler)(rn_socket_t *socket, void *arg), void *arg);
+void rn_dispatcher_destroy(rn_dispatcher_t *dispatcher);
+void rn_dispatcher_select(rn_dispatcher_t *dispatcher, int (*select)(rn_dispatcher_t *dispatcher, const rn_addr_t *from));
+int rn_dispatcher_gauges(rn_dispatcher_t *dispatcher, int id, rn_dispatch_gauges_t *gauges);
+int rn_dispatcher_dispatch(rn_dispatcher_t *dispatcher, rn_socket_t *socket, const rn_addr_t *from);
+int rn_dispatcher_accept(rn_dispatcher_t *dispatcher, rn_socket_t *server);
+
+#endif /* !RINOO_NET_DISPATCHER_H_ */
@@ -14,19 +14,32 @@
 #define _GNU_SOURCE
 
 #include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
+#include <poll.h>
 #include <string.h>
 #include <sys/uio.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <sys/sendfile.h>
+#include <netinet/tcp.h>
+#include <netinet/udp.h>
+#include <linux/errqueue.h>
 #include <openssl/ssl.h>
 #include <openssl/pem.h>
+#include <openssl/err.h>
 #include <openssl/conf.h>
 #include <openssl/x509v3.h>
+#include <openssl/rand.h>
+#include <openssl/hmac.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+# include <openssl/core_names.h>
+#endif
 
 #include "rinoo/global/module.h"
 #include "rinoo/memory/module.h"
@@ -35,11 +48,20 @@
 
 #include "rinoo/net/socket_class.h"
 #include "rinoo/net/socket.h"
+#include "rinoo/net/ratelimit.h"
 #include "rinoo/net/socket_class_tcp.h"
 #include "rinoo/net/socket_class_udp.h"
+#include "rinoo/net/socket_class_unix.h"
 #include "rinoo/net/socket_class_ssl.h"
 #include "rinoo/net/tcp.h"
+#include "rinoo/net/tcp_pool.h"
 #include "rinoo/net/udp.h"
+#include "rinoo/net/unix.h"
+#include "rinoo/net/bufreader.h"
+#include "rinoo/net/bufwriter.h"
+#include "rinoo/net/ssl_cache.h"
+#include "rinoo/net/ssl_offload.h"
 #include "rinoo/net/ssl.h"
+#include "rinoo/net/dispatcher.h"
 
 #endif /* !RINOO_MODULE_NET_H_ */
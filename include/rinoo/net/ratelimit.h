@@ -0,0 +1,64 @@
+/**
+ * @file   ratelimit.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for socket bandwidth shaping declarations
+ *
+ *
+ */
+
+#ifndef RINOO_NET_RATELIMIT_H_
+#define RINOO_NET_RATELIMIT_H_
+
+typedef struct rn_ratelimit_s {
+	/* Bytes per second */
+	uint64_t rate;
+	/* Bucket size in bytes */
+	uint64_t burst;
+	/* Available bytes, negative after a datagram larger than what was available */
+	int64_t tokens;
+	struct timeval last;
+} rn_ratelimit_t;
+
+rn_ratelimit_t *rn_ratelimit(uint64_t rate, uint64_t burst);
+void rn_ratelimit_destroy(rn_ratelimit_t *limit);
+int rn_socket_ratelimit(rn_socket_t *socket, uint64_t rate, uint64_t burst);
+int rn_socket_ratelimit_group(rn_socket_t *socket, rn_ratelimit_t *group);
+void rn_socket_ratelimit_reset(rn_socket_t *socket);
+ssize_t rn_socket_ratelimit_wait(rn_socket_t *socket, size_t count);
+void rn_socket_ratelimit_consume(rn_socket_t *socket, size_t count);
+
+/**
+ * Waits for a rate limited socket to be allowed to send data.
+ *
+ * @param socket Pointer to the socket
+ * @param count Number of bytes to send
+ *
+ * @return Number of bytes which can be sent now (at most count), or -1 if an error occurs
+ */
+static inline ssize_t rn_socket_throttle(rn_socket_t *socket, size_t count)
+{
+	if (likely((socket->flags & RN_SOCKET_FLAG_RATELIMIT) == 0)) {
+		return count;
+	}
+	return rn_socket_ratelimit_wait(socket, count);
+}
+
+/**
+ * Accounts data sent on a rate limited socket.
+ *
+ * @param socket Pointer to the socket
+ * @param ret Send syscall return value (bytes sent, or -1)
+ *
+ * @return ret
+ */
+static inline ssize_t rn_socket_throttled(rn_socket_t *socket, ssize_t ret)
+{
+	if (unlikely((socket->flags & RN_SOCKET_FLAG_RATELIMIT) != 0) && ret > 0) {
+		rn_socket_ratelimit_consume(socket, ret);
+	}
+	return ret;
+}
+
+#endif /* !RINOO_NET_RATELIMIT_H_ */
@@ -11,28 +11,63 @@
 #ifndef RINOO_NET_SOCKET_H_
 #define RINOO_NET_SOCKET_H_
 
-#define MAX_IO_CALLS	10
+#define MAX_IO_CALLS		10
+#define RN_SPLICE_SIZE		(64 * 1024)
+#define RN_SPLICE_BUFSIZE	(16 * 1024)
+
+#define RN_SOCKET_FLAG_AUTOCORK		0x1
+#define RN_SOCKET_FLAG_CORKED		0x2
+#define RN_SOCKET_FLAG_RATELIMIT	0x4
+#define RN_SOCKET_FLAG_GSOPROBED	0x8
+#define RN_SOCKET_FLAG_NOGSO		0x10
 
 typedef struct rn_socket_s {
 	int io_calls;
+	uint32_t flags;
 	rn_sched_node_t node;
 	struct rn_socket_s *parent;
+	struct rn_zerocopy_s *zerocopy;
+	struct rn_ratelimit_s *ratelimit;
+	struct rn_ratelimit_s *ratelimit_group;
 	const rn_socket_class_t *class;
+	rn_task_t *cork_task;
+	rn_task_hook_t cork_hook;
+	rn_stats_t stats;
 } rn_socket_t;
 
 typedef union rn_addr_u {
 	struct sockaddr sa;
 	struct sockaddr_in v4;
 	struct sockaddr_in6 v6;
+	struct sockaddr_un un;
 } rn_addr_t;
 
+typedef struct rn_msg_s {
+	void *buf;
+	size_t size;
+	size_t len;
+	rn_addr_t addr;
+} rn_msg_t;
+
+typedef struct rn_socket_relay_s {
+	int refs;
+	int error;
+	bool done;
+	rn_task_t *task;
+	rn_socket_t *a;
+	rn_socket_t *b;
+} rn_socket_relay_t;
+
 #define IS_IPV4(addr)			((addr)->sa.sa_family == AF_INET)
 #define IS_IPV6(addr)			((addr)->sa.sa_family == AF_INET6)
+#define IS_UNIX(addr)			((addr)->sa.sa_family == AF_UNIX)
 #define rn_addr_getip(addr, dst, len)	(inet_ntop((addr)->sa.sa_family, (addr), (dst), (len)))
 #define rn_addr_getport(addr)		(IS_IPV4(addr) ? (addr)->v4.sin_port : (addr)->v6.sin6_port)
 
 int rn_addr4(rn_addr_t *dest, const char *src, uint16_t port);
 int rn_addr6(rn_addr_t *dest, const char *src, uint16_t port);
+int rn_addr_un(rn_addr_t *dest, const char *path);
+socklen_t rn_addr_len(const rn_addr_t *addr);
 
 int rn_socket_init(rn_sched_t *sched, rn_socket_t *sock, const rn_socket_class_t *class);
 rn_socket_t *rn_socket(rn_sched_t *sched, const rn_socket_class_t *class);
@@ -46,6 +81,12 @@ int rn_socket_waitin(rn_socket_t *socket);
 int rn_socket_waitout(rn_socket_t *socket);
 int rn_socket_waitio(rn_socket_t *socket);
 int rn_socket_timeout(rn_socket_t *socket, uint32_t ms);
+int rn_socket_timeout_us(rn_socket_t *socket, uint64_t us);
+int rn_socket_deadline(rn_socket_t *socket, uint32_t read_ms, uint32_t write_ms, uint32_t idle_ms);
+int rn_socket_setopt(rn_socket_t *socket, rn_socket_opt_t opt, int value);
+int rn_socket_getopt(rn_socket_t *socket, rn_socket_opt_t opt, int *value);
+void rn_socket_stats_io(rn_socket_t *socket, rn_sched_mode_t mode, ssize_t ret);
+const rn_stats_t *rn_socket_stats(rn_socket_t *socket);
 
 int rn_socket_connect(rn_socket_t *socket, const rn_addr_t *dst);
 int rn_socket_bind(rn_socket_t *socket, const rn_addr_t *dst, int backlog);
@@ -55,10 +96,56 @@ ssize_t rn_socket_recvfrom(rn_socket_t *socket, void *buf, size_t count, rn_addr
 ssize_t rn_socket_write(rn_socket_t *socket, const void *buf, size_t count);
 ssize_t rn_socket_writev(rn_socket_t *socket, rn_buffer_t **buffers, int count);
 ssize_t rn_socket_sendto(rn_socket_t *socket, void *buf, size_t count, const rn_addr_t *dst);
+int rn_socket_recvmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count);
+int rn_socket_sendmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count);
 ssize_t rn_socket_readb(rn_socket_t *socket, rn_buffer_t *buffer);
 ssize_t rn_socket_readline(rn_socket_t *socket, rn_buffer_t *buffer, const char *delim, size_t maxsize);
 ssize_t rn_socket_expect(rn_socket_t *socket, rn_buffer_t *buffer, const char *expected);
 ssize_t rn_socket_writeb(rn_socket_t *socket, rn_buffer_t *buffer);
 ssize_t rn_socket_sendfile(rn_socket_t *socket, int in_fd, off_t offset, size_t count);
+ssize_t rn_socket_splice(rn_socket_t *in, rn_socket_t *out, size_t max);
+int rn_socket_relay(rn_socket_t *a, rn_socket_t *b);
+
+/**
+ * Accounts a read syscall on a socket, when I/O accounting is enabled.
+ * Data read restarts the socket idle period (see rn_socket_deadline).
+ *
+ * @param socket Pointer to the socket
+ * @param ret Syscall return value (bytes read, or -1 with errno set)
+ *
+ * @return ret
+ */
+static inline ssize_t rn_socket_stat_in(rn_socket_t *socket, ssize_t ret)
+{
+	if (rn_stats_enabled(socket->node.sched)) {
+		rn_socket_stats_io(socket, RN_MODE_IN, ret);
+	}
+	if (unlikely(socket->node.deadline.idle != 0) && ret > 0) {
+		/* The scheduler clock may be late when the task did not wait */
+		gettimeofday(&socket->node.deadline.active, NULL);
+	}
+	return ret;
+}
+
+/**
+ * Accounts a write syscall on a socket, when I/O accounting is enabled.
+ * Data written restarts the socket idle period (see rn_socket_deadline).
+ *
+ * @param socket Pointer to the socket
+ * @param ret Syscall return value (bytes written, or -1 with errno set)
+ *
+ * @return ret
+ */
+static inline ssize_t rn_socket_stat_out(rn_socket_t *socket, ssize_t ret)
+{
+	if (rn_stats_enabled(socket->node.sched)) {
+		rn_socket_stats_io(socket, RN_MODE_OUT, ret);
+	}
+	if (unlikely(socket->node.deadline.idle != 0) && ret > 0) {
+		/* The scheduler clock may be late when the task did not wait */
+		gettimeofday(&socket->node.deadline.active, NULL);
+	}
+	return ret;
+}
 
 #endif /* !RINOO_NET_SOCKET_H_ */
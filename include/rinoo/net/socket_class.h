@@ -13,10 +13,25 @@
 
 struct rn_socket_s;
 union rn_addr_u;
+struct rn_msg_s;
+
+typedef enum rn_socket_opt_e {
+	RN_SOCKET_NODELAY = 0,
+	RN_SOCKET_CORK,
+	RN_SOCKET_AUTOCORK,
+	RN_SOCKET_NOTSENT_LOWAT,
+	RN_SOCKET_SNDBUF,
+	RN_SOCKET_RCVBUF,
+	RN_SOCKET_DEFER_ACCEPT,
+	RN_SOCKET_FASTOPEN,
+	RN_SOCKET_NBOPTS
+} rn_socket_opt_t;
 
 typedef struct rn_socket_class_s {
 	int domain;
 	int type;
+	/* Options set on new sockets, 0 keeps the system default */
+	int options[RN_SOCKET_NBOPTS];
 	struct rn_socket_s *(*create)(rn_sched_t *sched);
 	void (*destroy)(struct rn_socket_s *socket);
 	int (*open)(struct rn_socket_s *socket);
@@ -28,6 +43,8 @@ typedef struct rn_socket_class_s {
 	ssize_t (*writev)(struct rn_socket_s *socket, rn_buffer_t **buffers, int count);
 	ssize_t (*sendto)(struct rn_socket_s *socket, void *buf, size_t count, const union rn_addr_u *dst);
 	ssize_t (*sendfile)(struct rn_socket_s *socket, int in_fd, off_t offset, size_t count);
+	int (*recvmmsg)(struct rn_socket_s *socket, struct rn_msg_s *msgs, int count);
+	int (*sendmmsg)(struct rn_socket_s *socket, struct rn_msg_s *msgs, int count);
 	int (*connect)(struct rn_socket_s *socket, const union rn_addr_u *dst);
 	int (*bind)(struct rn_socket_s *socket, const union rn_addr_u *dst, int backlog);
 	struct rn_socket_s *(*accept)(struct rn_socket_s *socket, union rn_addr_u *from);
@@ -13,8 +13,12 @@
 
 rn_socket_t *rn_socket_class_ssl_create(rn_sched_t *sched);
 void rn_socket_class_ssl_destroy(rn_socket_t *socket);
+rn_socket_t *rn_socket_class_ssl_dup(rn_sched_t *destination, rn_socket_t *socket);
+int rn_socket_class_ssl_close(rn_socket_t *socket);
 ssize_t rn_socket_class_ssl_read(rn_socket_t *socket, void *buf, size_t count);
 ssize_t	rn_socket_class_ssl_write(rn_socket_t *socket, const void *buf, size_t count);
+ssize_t	rn_socket_class_ssl_writev(rn_socket_t *socket, rn_buffer_t **buffers, int count);
+ssize_t rn_socket_class_ssl_sendfile(rn_socket_t *socket, int in_fd, off_t offset, size_t count);
 int rn_socket_class_ssl_connect(rn_socket_t *socket, const rn_addr_t *dst);
 rn_socket_t *rn_socket_class_ssl_accept(rn_socket_t *socket, rn_addr_t *from);
 
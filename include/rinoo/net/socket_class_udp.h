@@ -11,6 +11,8 @@
 #ifndef RINOO_NET_SOCKET_CLASS_UDP_H_
 #define RINOO_NET_SOCKET_CLASS_UDP_H_
 
+#define RN_MMSG_MAX	32
+
 rn_socket_t *rn_socket_class_udp_create(rn_sched_t *sched);
 void rn_socket_class_udp_destroy(rn_socket_t *socket);
 int rn_socket_class_udp_open(rn_socket_t *sock);
@@ -21,6 +23,8 @@ ssize_t rn_socket_class_udp_recvfrom(rn_socket_t *socket, void *buf, size_t coun
 ssize_t rn_socket_class_udp_write(rn_socket_t *socket, const void *buf, size_t count);
 ssize_t rn_socket_class_udp_writev(rn_socket_t *socket, rn_buffer_t **buffers, int count);
 ssize_t rn_socket_class_udp_sendto(rn_socket_t *socket, void *buf, size_t count, const rn_addr_t *dst);
+int rn_socket_class_udp_recvmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count);
+int rn_socket_class_udp_sendmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count);
 ssize_t rn_socket_class_udp_sendfile(rn_socket_t *socket, int in_fd, off_t offset, size_t count);
 int rn_socket_class_udp_connect(rn_socket_t *socket, const rn_addr_t *dst);
 int rn_socket_class_udp_bind(rn_socket_t *socket, const rn_addr_t *dst, int backlog);
@@ -0,0 +1,19 @@
+/**
+ * @file   socket_class_unix.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Unix domain socket classes
+ *
+ *
+ */
+
+#ifndef RINOO_NET_SOCKET_CLASS_UNIX_H_
+#define RINOO_NET_SOCKET_CLASS_UNIX_H_
+
+ssize_t rn_socket_class_unix_recvfrom(rn_socket_t *socket, void *buf, size_t count, rn_addr_t *from);
+int rn_socket_class_unix_recvmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count);
+int rn_socket_class_unix_connect(rn_socket_t *socket, const rn_addr_t *dst);
+int rn_socket_class_unix_bind(rn_socket_t *socket, const rn_addr_t *dst, int backlog);
+
+#endif /* !RINOO_NET_SOCKET_CLASS_UNIX_H_ */
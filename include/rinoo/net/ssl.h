@@ -11,21 +11,33 @@
 #ifndef RINOO_NET_SSL_H_
 #define RINOO_NET_SSL_H_
 
+#define RN_SSL_RECORD_SIZE	SSL3_RT_MAX_PLAIN_LENGTH
+
 typedef struct rn_ssl_ctx_s {
 	X509 *x509;
 	EVP_PKEY *pkey;
 	SSL_CTX *ctx;
+	rn_ssl_cache_t *cache;
+	rn_ssl_offload_t *offload;
 } rn_ssl_ctx_t;
 
 typedef struct rn_ssl_s {
+	bool ktls;
+	/* Set after a fatal error, the connection must not be shut down */
+	bool fatal;
 	SSL *ssl;
+	char *record;
 	rn_ssl_ctx_t *ctx;
+	/* Socket whose SSL connection is shared by a duplicate, NULL otherwise */
+	struct rn_ssl_s *origin;
 	rn_socket_t socket;
 } rn_ssl_t;
 
 rn_ssl_ctx_t *rn_ssl_context(void);
 void rn_ssl_context_destroy(rn_ssl_ctx_t *ctx);
 rn_ssl_t *rn_ssl_get(rn_socket_t *socket);
+bool rn_ssl_ktls(rn_socket_t *socket);
+bool rn_ssl_reused(rn_socket_t *socket);
 rn_socket_t *rn_ssl_client(rn_sched_t *sched, rn_ssl_ctx_t *ctx, rn_addr_t *dst, uint32_t timeout);
 rn_socket_t *rn_ssl_server(rn_sched_t *sched, rn_ssl_ctx_t *ctx, rn_addr_t *dst);
 
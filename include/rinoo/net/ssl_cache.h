@@ -0,0 +1,56 @@
+/**
+ * @file   ssl_cache.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for TLS session cache and ticket declarations
+ *
+ *
+ */
+
+#ifndef RINOO_NET_SSL_CACHE_H_
+#define RINOO_NET_SSL_CACHE_H_
+
+#define RN_SSL_CACHE_SHARDS	16
+#define RN_SSL_CACHE_SLOTS	1024
+#define RN_SSL_CLIENT_SLOTS	256
+#define RN_SSL_TICKET_KEYS	2
+#define RN_SSL_TICKET_LIFETIME	3600
+
+/* Defined in ssl.h */
+struct rn_ssl_ctx_s;
+
+typedef struct rn_ssl_cache_shard_s {
+	pthread_mutex_t lock;
+	SSL_SESSION *sessions[RN_SSL_CACHE_SLOTS];
+} rn_ssl_cache_shard_t;
+
+typedef struct rn_ssl_client_session_s {
+	rn_addr_t addr;
+	SSL_SESSION *session;
+} rn_ssl_client_session_t;
+
+typedef struct rn_ssl_ticket_key_s {
+	time_t created;
+	unsigned char name[16];
+	unsigned char aes[32];
+	unsigned char hmac[32];
+} rn_ssl_ticket_key_t;
+
+typedef struct rn_ssl_cache_s {
+	rn_ssl_cache_shard_t shards[RN_SSL_CACHE_SHARDS];
+	pthread_mutex_t client_lock;
+	rn_ssl_client_session_t clients[RN_SSL_CLIENT_SLOTS];
+	pthread_mutex_t ticket_lock;
+	uint32_t ticket_lifetime;
+	rn_ssl_ticket_key_t tickets[RN_SSL_TICKET_KEYS];
+} rn_ssl_cache_t;
+
+int rn_ssl_cache(struct rn_ssl_ctx_s *ctx);
+void rn_ssl_cache_destroy(struct rn_ssl_ctx_s *ctx);
+void rn_ssl_cache_client_store(struct rn_ssl_ctx_s *ctx, SSL *ssl);
+SSL_SESSION *rn_ssl_cache_client(struct rn_ssl_ctx_s *ctx, const rn_addr_t *dst);
+int rn_ssl_ticket_rotate(struct rn_ssl_ctx_s *ctx);
+void rn_ssl_ticket_lifetime(struct rn_ssl_ctx_s *ctx, uint32_t seconds);
+
+#endif /* !RINOO_NET_SSL_CACHE_H_ */
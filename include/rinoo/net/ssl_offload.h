@@ -0,0 +1,41 @@
+/**
+ * @file   ssl_offload.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for TLS handshake offload declarations
+ *
+ *
+ */
+
+#ifndef RINOO_NET_SSL_OFFLOAD_H_
+#define RINOO_NET_SSL_OFFLOAD_H_
+
+#define RN_SSL_OFFLOAD_WORKERS	4
+
+/* Defined in ssl.h */
+struct rn_ssl_s;
+struct rn_ssl_ctx_s;
+
+typedef struct rn_ssl_job_s {
+	int ret;
+	int error;
+	SSL *ssl;
+	rn_fd_t *done;
+	rn_list_node_t node;
+} rn_ssl_job_t;
+
+typedef struct rn_ssl_offload_s {
+	bool stop;
+	uint32_t count;
+	pthread_t *workers;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	rn_list_t jobs;
+} rn_ssl_offload_t;
+
+int rn_ssl_offload(struct rn_ssl_ctx_s *ctx, uint32_t count);
+void rn_ssl_offload_destroy(struct rn_ssl_ctx_s *ctx);
+int rn_ssl_offload_handshake(struct rn_ssl_s *ssl);
+
+#endif /* !RINOO_NET_SSL_OFFLOAD_H_ */
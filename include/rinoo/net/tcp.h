@@ -11,9 +11,36 @@
 #ifndef RINOO_NET_TCP_H_
 #define RINOO_NET_TCP_H_
 
-#define RN_TCP_BACKLOG	128
+#ifndef SO_ZEROCOPY
+# define SO_ZEROCOPY	60
+#endif
+#ifndef MSG_ZEROCOPY
+# define MSG_ZEROCOPY	0x4000000
+#endif
+
+#define RN_TCP_BACKLOG			128
+#define RN_TCP_FASTOPEN_QLEN		RN_TCP_BACKLOG
+#define RN_TCP_ZEROCOPY_THRESHOLD	(10 * 1024)
+
+typedef struct rn_zerocopy_buffer_s {
+	uint32_t seq;
+	rn_buffer_t *buffer;
+	rn_list_node_t node;
+} rn_zerocopy_buffer_t;
+
+typedef struct rn_zerocopy_s {
+	uint32_t sent;
+	uint32_t completed;
+	uint64_t copied;
+	rn_list_t pending;
+} rn_zerocopy_t;
 
 rn_socket_t *rn_tcp_client(rn_sched_t *sched, rn_addr_t *dst, uint32_t timeout);
+rn_socket_t *rn_tcp_client_data(rn_sched_t *sched, rn_addr_t *dst, uint32_t timeout, const void *buf, size_t count, bool *fastopen);
 rn_socket_t *rn_tcp_server(rn_sched_t *sched, rn_addr_t *dst);
+int rn_tcp_zerocopy(rn_socket_t *socket);
+void rn_tcp_zerocopy_destroy(rn_socket_t *socket);
+ssize_t rn_tcp_sendzc(rn_socket_t *socket, rn_buffer_t *buffer);
+int rn_tcp_zcflush(rn_socket_t *socket);
 
 #endif /* !RINOO_NET_TCP_H_ */
@@ -0,0 +1,51 @@
+/**
+ * @file   tcp_pool.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for outbound TCP connection pool declarations
+ *
+ *
+ */
+
+#ifndef RINOO_NET_TCP_POOL_H_
+#define RINOO_NET_TCP_POOL_H_
+
+#define RN_TCP_POOL_HSIZE		64
+#define RN_TCP_POOL_MAX_IDLE		16
+#define RN_TCP_POOL_MAX_TOTAL		64
+#define RN_TCP_POOL_IDLE_TIMEOUT	30000
+
+typedef struct rn_tcp_pool_dest_s {
+	rn_addr_t addr;
+	uint32_t total;
+	rn_list_t idle;
+	rn_htable_node_t node;
+} rn_tcp_pool_dest_t;
+
+typedef struct rn_tcp_pool_conn_s {
+	struct timeval since;
+	rn_socket_t *socket;
+	rn_tcp_pool_dest_t *dest;
+	rn_list_node_t dest_node;
+	rn_list_node_t lru_node;
+} rn_tcp_pool_conn_t;
+
+typedef struct rn_tcp_pool_s {
+	uint32_t max_idle;
+	uint32_t max_total;
+	uint32_t idle_timeout;
+	uint64_t hits;
+	uint64_t misses;
+	rn_sched_t *sched;
+	rn_task_t *reaper;
+	rn_list_t lru;
+	rn_htable_t dests;
+} rn_tcp_pool_t;
+
+rn_tcp_pool_t *rn_tcp_pool(rn_sched_t *sched, uint32_t max_idle, uint32_t max_total, uint32_t idle_timeout);
+void rn_tcp_pool_destroy(rn_tcp_pool_t *pool);
+rn_socket_t *rn_tcp_pool_get(rn_tcp_pool_t *pool, rn_addr_t *dst, uint32_t timeout);
+void rn_tcp_pool_release(rn_tcp_pool_t *pool, rn_socket_t *socket, rn_addr_t *dst, bool reuse);
+
+#endif /* !RINOO_NET_TCP_POOL_H_ */
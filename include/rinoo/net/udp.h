@@ -11,6 +11,32 @@
 #ifndef RINOO_NET_UDP_H_
 #define RINOO_NET_UDP_H_
 
+#ifndef UDP_SEGMENT
+# define UDP_SEGMENT	103
+#endif
+#ifndef UDP_GRO
+# define UDP_GRO	104
+#endif
+
+#define RN_UDP_GSO_MAX_SEGMENTS	64
+#define RN_UDP_GSO_MAX_SIZE	65507
+#define RN_UDP_MSG_SIZE		4096
+
+typedef struct rn_udp_serve_s {
+	void *arg;
+	rn_task_t *task;
+	rn_socket_t *socket;
+	rn_list_node_t lnode;
+	rn_msg_t msgs[RN_MMSG_MAX];
+	void (*handler)(rn_socket_t *socket, rn_msg_t *msg, void *arg);
+	char bufs[RN_MMSG_MAX][RN_UDP_MSG_SIZE];
+} rn_udp_serve_t;
+
 rn_socket_t *rn_udp_client(rn_sched_t *sched, rn_addr_t *dst);
+rn_socket_t *rn_udp_server(rn_sched_t *sched, rn_addr_t *dst);
+int rn_udp_serve(rn_sched_t *sched, rn_addr_t *dst, void (*handler)(rn_socket_t *socket, rn_msg_t *msg, void *arg), void *arg);
+ssize_t rn_udp_sendgso(rn_socket_t *socket, const void *buf, size_t count, uint16_t segsize, const rn_addr_t *dst);
+int rn_udp_gro(rn_socket_t *socket, bool enabled);
+ssize_t rn_udp_recvgro(rn_socket_t *socket, void *buf, size_t count, rn_addr_t *from, uint16_t *segsize);
 
 #endif /* !RINOO_NET_UDP_H_ */
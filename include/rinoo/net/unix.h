@@ -0,0 +1,22 @@
+/**
+ * @file   unix.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for unix domain socket function declarations
+ *
+ *
+ */
+
+#ifndef RINOO_NET_UNIX_H_
+#define RINOO_NET_UNIX_H_
+
+#define RN_UNIX_BACKLOG		RN_TCP_BACKLOG
+#define RN_UNIX_MAXFDS		64
+
+rn_socket_t *rn_unix_client(rn_sched_t *sched, rn_addr_t *dst, int type, uint32_t timeout);
+rn_socket_t *rn_unix_server(rn_sched_t *sched, rn_addr_t *dst, int type);
+int rn_socket_sendfd(rn_socket_t *socket, const int *fds, int count);
+int rn_socket_recvfd(rn_socket_t *socket, rn_socket_t **sockets, int count);
+
+#endif /* !RINOO_NET_UNIX_H_ */
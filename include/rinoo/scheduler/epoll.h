@@ -22,6 +22,7 @@ enum rn_sched_mode_e;		/* Defined in scheduler.h */
 typedef struct rn_epoll_s {
 	int fd;
 	int curevent;
+	bool highres;
 	struct epoll_event events[RN_EPOLL_MAX_EVENTS];
 } rn_epoll_t;
 
@@ -30,6 +31,6 @@ void rn_epoll_destroy(struct rn_sched_s *sched);
 int rn_epoll_insert(struct rn_sched_node_s *node, enum rn_sched_mode_e mode);
 int rn_epoll_addmode(struct rn_sched_node_s *node, enum rn_sched_mode_e mode);
 int rn_epoll_remove(struct rn_sched_node_s *node);
-int rn_epoll_poll(struct rn_sched_s *sched, int timeout);
+int rn_epoll_poll(struct rn_sched_s *sched, int64_t timeout);
 
 #endif /* !RINOO_RINOO_EPOLL_H_ */
@@ -0,0 +1,35 @@
+/**
+ * @file   fd.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for generic file descriptor declarations.
+ *
+ *
+ */
+
+#ifndef RINOO_SCHEDULER_FD_H_
+#define RINOO_SCHEDULER_FD_H_
+
+#define RN_FD_MAX_IO_CALLS	10
+
+typedef struct rn_fd_s {
+	int io_calls;
+	rn_sched_node_t node;
+} rn_fd_t;
+
+rn_fd_t *rn_fd(rn_sched_t *sched, int fd);
+void rn_fd_destroy(rn_fd_t *fd);
+int rn_fd_waitin(rn_fd_t *fd);
+int rn_fd_waitout(rn_fd_t *fd);
+ssize_t rn_fd_read(rn_fd_t *fd, void *buf, size_t count);
+ssize_t rn_fd_write(rn_fd_t *fd, const void *buf, size_t count);
+
+rn_fd_t *rn_eventfd(rn_sched_t *sched, unsigned int initval);
+int rn_eventfd_read(rn_fd_t *fd, uint64_t *value);
+int rn_eventfd_write(rn_fd_t *fd, uint64_t value);
+
+rn_fd_t *rn_signalfd(rn_sched_t *sched, const sigset_t *mask);
+int rn_signalfd_read(rn_fd_t *fd, struct signalfd_siginfo *info);
+
+#endif /* !RINOO_SCHEDULER_FD_H_ */
@@ -20,12 +20,23 @@ typedef enum rn_sched_mode_e {
 	RN_MODE_OUT = 2,
 } rn_sched_mode_t;
 
+typedef struct rn_sched_deadline_s {
+	/* Timeouts in milliseconds, 0 when disabled */
+	uint32_t in;
+	uint32_t out;
+	uint32_t idle;
+	/* Last I/O event, start of the idle period */
+	struct timeval active;
+} rn_sched_deadline_t;
+
 typedef struct rn_sched_node_s {
 	int fd;
 	int error;
+	bool errqueue;
 	rn_task_t *task;
 	unsigned char modes;
 	rn_list_node_t lnode;
+	rn_sched_deadline_t deadline;
 	struct rn_sched_s *sched;
 } rn_sched_node_t;
 
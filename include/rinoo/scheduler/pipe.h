@@ -0,0 +1,28 @@
+/**
+ * @file   pipe.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for scheduler pipe pool declarations.
+ *
+ *
+ */
+
+#ifndef RINOO_SCHEDULER_PIPE_H_
+#define RINOO_SCHEDULER_PIPE_H_
+
+#define RN_PIPE_POOL_SIZE	16
+
+/* Defined in scheduler.h */
+struct rn_sched_s;
+
+typedef struct rn_sched_pipes_s {
+	int count;
+	int fds[RN_PIPE_POOL_SIZE][2];
+} rn_sched_pipes_t;
+
+int rn_pipe_get(struct rn_sched_s *sched, int fds[2]);
+void rn_pipe_release(struct rn_sched_s *sched, int fds[2]);
+void rn_pipe_destroy(struct rn_sched_s *sched);
+
+#endif /* !RINOO_SCHEDULER_PIPE_H_ */
@@ -0,0 +1,41 @@
+/**
+ * @file   profiler.h
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Header file for task sampling profiler declarations.
+ *
+ *
+ */
+
+#ifndef RINOO_SCHEDULER_PROFILER_H_
+#define RINOO_SCHEDULER_PROFILER_H_
+
+#define RN_PROFILER_DEPTH	32
+#define RN_PROFILER_SAMPLES	8192
+
+/* Defined in scheduler.h */
+struct rn_sched_s;
+
+typedef struct rn_profiler_sample_s {
+	void (*function)(void *arg);
+	uint32_t depth;
+	void *frames[RN_PROFILER_DEPTH];
+} rn_profiler_sample_t;
+
+typedef struct rn_profiler_s {
+	bool running;
+	timer_t timer;
+	char *stack_low;
+	char *stack_high;
+	volatile uint32_t count;
+	volatile uint32_t dropped;
+	rn_profiler_sample_t samples[RN_PROFILER_SAMPLES];
+} rn_profiler_t;
+
+int rn_profiler_start(struct rn_sched_s *sched, uint32_t hz);
+int rn_profiler_stop(struct rn_sched_s *sched);
+void rn_profiler_destroy(struct rn_sched_s *sched);
+int rn_profiler_dump(struct rn_sched_s *sched, FILE *output);
+
+#endif /* !RINOO_SCHEDULER_PROFILER_H_ */
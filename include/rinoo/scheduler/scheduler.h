@@ -11,15 +11,60 @@
 #ifndef RINOO_SCHEDULER_SCHEDULER_H_
 #define RINOO_SCHEDULER_SCHEDULER_H_
 
+#define RN_ADMISSION_WAIT	10
+
+typedef enum rn_admission_mode_e {
+	RN_ADMISSION_OFF = 0,
+	RN_ADMISSION_PAUSE,
+	RN_ADMISSION_REJECT,
+} rn_admission_mode_t;
+
+typedef struct rn_sched_admission_s {
+	rn_admission_mode_t mode;
+	uint32_t max_tasks;
+	uint32_t max_lag;
+	uint64_t paused;
+	uint64_t rejected;
+} rn_sched_admission_t;
+
+typedef struct rn_stats_s {
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	uint64_t reads;
+	uint64_t writes;
+	uint64_t eagain;
+	uint64_t waitin;
+	uint64_t waitout;
+	/* Time spent waiting for I/O in microseconds */
+	uint64_t suspended;
+} rn_stats_t;
+
+typedef struct rn_sched_stats_s {
+	bool enabled;
+	rn_stats_t total;
+} rn_sched_stats_t;
+
+#ifdef RINOO_NO_STATS
+# define rn_stats_enabled(sched)	false
+#else
+# define rn_stats_enabled(sched)	unlikely((sched)->stats.enabled)
+#endif
+
 typedef struct rn_sched_s {
 	int id;
 	bool stop;
 	rn_list_t nodes;
+	uint32_t lag;
 	uint32_t nbpending;
 	struct timeval clock;
+	struct timeval awake;
+	rn_sched_admission_t admission;
+	rn_sched_stats_t stats;
 	rn_task_driver_t driver;
 	struct rn_epoll_s epoll;
 	rn_sched_spawns_t spawns;
+	rn_sched_pipes_t pipes;
+	rn_profiler_t *profiler;
 } rn_sched_t;
 
 rn_sched_t *rn_scheduler(void);
@@ -27,11 +72,17 @@ void rn_scheduler_destroy(rn_sched_t *sched);
 int rn_scheduler_spawn(rn_sched_t *sched, int count);
 rn_sched_t *rn_scheduler_spawn_get(rn_sched_t *sched, int id);
 rn_sched_t *rn_scheduler_self(void);
+void rn_scheduler_now(rn_sched_t *sched, struct timeval *now);
 void rn_scheduler_stop(rn_sched_t *sched);
 int rn_scheduler_waitfor(rn_sched_node_t *node,  rn_sched_mode_t mode);
+int rn_scheduler_deadline(rn_sched_node_t *node, uint32_t in, uint32_t out, uint32_t idle);
 int rn_scheduler_remove(rn_sched_node_t *node);
 void rn_scheduler_wakeup(rn_sched_node_t *node, rn_sched_mode_t mode, int error);
 int rn_scheduler_poll(rn_sched_t *sched);
 void rn_scheduler_loop(rn_sched_t *sched);
+int rn_scheduler_admission(rn_sched_t *sched, rn_admission_mode_t mode, uint32_t max_tasks, uint32_t max_lag);
+bool rn_scheduler_overloaded(rn_sched_t *sched);
+int rn_scheduler_stats_enable(rn_sched_t *sched, bool enabled);
+const rn_stats_t *rn_scheduler_stats(rn_sched_t *sched);
 
 #endif /* !RINOO_SCHEDULER_SCHEDULER_H_ */
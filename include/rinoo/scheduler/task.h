@@ -16,12 +16,19 @@
 /* Defined in scheduler.h */
 struct rn_sched_s;
 
+typedef struct rn_task_hook_s {
+	void (*func)(struct rn_task_hook_s *hook);
+	rn_list_node_t node;
+} rn_task_hook_t;
+
 typedef struct rn_task_s {
 	bool scheduled;
 	struct timeval tv;
 	struct rn_sched_s *sched;
+	rn_list_t hooks;
 	rn_rbtree_node_t proc_node;
 	rn_fcontext_t context;
+	void (*function)(void *arg);
 	char stack[RN_TASK_STACK_SIZE];
 
 #ifdef RINOO_DEBUG
@@ -29,18 +36,29 @@ typedef struct rn_task_s {
 #endif /* !RINOO_DEBUG */
 } rn_task_t;
 
+typedef struct rn_task_stats_s {
+	uint64_t wakeups;
+	uint64_t expired;
+	uint64_t saved;
+} rn_task_stats_t;
+
 typedef struct rn_task_driver_s {
 	rn_task_t main;
 	rn_task_t *current;
 	rn_rbtree_t proc_tree;
+	uint32_t nbtasks;
+	uint32_t slack;
+	rn_task_stats_t stats;
 } rn_task_driver_t;
 
 int rn_task_driver_init(struct rn_sched_s *sched);
 void rn_task_driver_destroy(struct rn_sched_s *sched);
-int rn_task_driver_run(struct rn_sched_s *sched);
+int64_t rn_task_driver_run(struct rn_sched_s *sched);
 int rn_task_driver_stop(struct rn_sched_s *sched);
 uint32_t rn_task_driver_nbpending(struct rn_sched_s *sched);
 rn_task_t *rn_task_driver_getcurrent(struct rn_sched_s *sched);
+void rn_task_driver_slack(struct rn_sched_s *sched, uint32_t us);
+void rn_task_driver_stats(struct rn_sched_s *sched, rn_task_stats_t *stats);
 
 rn_task_t *rn_task(struct rn_sched_s *sched, rn_task_t *parent, void (*function)(void *arg), void *arg);
 void rn_task_destroy(rn_task_t *task);
@@ -52,7 +70,11 @@ int rn_task_schedule(rn_task_t *task, struct timeval *tv);
 int rn_task_unschedule(rn_task_t *task);
 int rn_task_start(struct rn_sched_s *sched, void (*function)(void *arg), void *arg);
 int rn_task_wait(struct rn_sched_s *sched, uint32_t ms);
+int rn_task_wait_us(struct rn_sched_s *sched, uint64_t us);
+int rn_task_delay_us(struct rn_sched_s *sched, uint64_t us);
 int rn_task_pause(struct rn_sched_s *sched);
 rn_task_t *rn_task_self(void);
+void rn_task_hook(rn_task_t *task, rn_task_hook_t *hook, void (*func)(rn_task_hook_t *hook));
+void rn_task_unhook(rn_task_t *task, rn_task_hook_t *hook);
 
 #endif /* RINOO_SCHEDULER_TASK_H_ */
@@ -18,11 +18,21 @@ if (MODE STREQUAL "debug")
   add_definitions("-O0")
   add_definitions("-D${PNAME}_DEBUG")
   message("Build mode: debug")
+elseif (MODE STREQUAL "profile")
+  add_definitions("-g")
+  add_definitions("-O2")
+  add_definitions("-fno-omit-frame-pointer")
+  set(CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} -rdynamic")
+  message("Build mode: profile")
 else (MODE STREQUAL "debug")
   add_definitions("-g0")
   add_definitions("-O3")
   message("Build mode: production")
 endif (MODE STREQUAL "debug")
+if (NOSTATS)
+  add_definitions("-DRINOO_NO_STATS")
+  message("Socket stats: disabled")
+endif (NOSTATS)
 
 ## Version ##
 
@@ -66,6 +76,13 @@ macro(check_dependency_sym symbol include)
   endif (NOT has_${symbol}_${include})
 endmacro(check_dependency_sym)
 
+macro(check_optional_func function define)
+  check_function_exists(${function} has_${function})
+  if (has_${function})
+    add_definitions("-D${define}")
+  endif (has_${function})
+endmacro(check_optional_func)
+
 ## !Dependencies ##
 
 ## Source files ##
@@ -0,0 +1,268 @@
+/**
+ * @file   bufreader.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Buffered socket reader
+ *
+ *
+ */
+
+#include "rinoo/net/module.h"
+
+/**
+ * Initializes a buffered reader on a socket.
+ * Data is read from the socket by windows of the reader size, and bytes
+ * left over by an operation are kept for the next ones, so that parsing
+ * small messages does not cost a read syscall each.
+ *
+ * @param reader Pointer to the reader to initialize
+ * @param socket Socket to read from
+ * @param size Window size (RN_BUFREADER_SIZE if 0)
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_bufreader(rn_bufreader_t *reader, rn_socket_t *socket, size_t size)
+{
+	XASSERT(reader != NULL, -1);
+	XASSERT(socket != NULL, -1);
+
+	if (size == 0) {
+		size = RN_BUFREADER_SIZE;
+	}
+	reader->buf = malloc(size);
+	if (unlikely(reader->buf == NULL)) {
+		rn_error_set(errno);
+		return -1;
+	}
+	reader->size = size;
+	reader->start = 0;
+	reader->end = 0;
+	reader->socket = socket;
+	return 0;
+}
+
+/**
+ * Frees a buffered reader. Buffered bytes are lost, the socket is left open.
+ *
+ * @param reader Pointer to the reader to destroy
+ */
+void rn_bufreader_destroy(rn_bufreader_t *reader)
+{
+	XASSERTN(reader != NULL);
+
+	free(reader->buf);
+	reader->buf = NULL;
+	reader->start = 0;
+	reader->end = 0;
+}
+
+/**
+ * Gets the number of bytes read from the socket and not consumed yet.
+ *
+ * @param reader Pointer to the reader
+ *
+ * @return Number of buffered bytes
+ */
+size_t rn_bufreader_buffered(rn_bufreader_t *reader)
+{
+	return reader->end - reader->start;
+}
+
+/**
+ * Reads more data from the socket into the window.
+ * Buffered bytes are moved to the window start first if needed,
+ * which invalidates pointers previously returned by the reader.
+ *
+ * @param reader Pointer to the reader
+ *
+ * @return Number of bytes read, 0 on end of file, or -1 if an error occurs (ENOBUFS if the window is full)
+ */
+ssize_t rn_bufreader_fill(rn_bufreader_t *reader)
+{
+	ssize_t ret;
+
+	if (reader->start == reader->end) {
+		reader->start = 0;
+		reader->end = 0;
+	} else if (reader->end == reader->size && reader->start > 0) {
+		memmove(reader->buf, reader->buf + reader->start, reader->end - reader->start);
+		reader->end -= reader->start;
+		reader->start = 0;
+	}
+	if (reader->end == reader->size) {
+		rn_error_set(ENOBUFS);
+		return -1;
+	}
+	ret = rn_socket_read(reader->socket, reader->buf + reader->end, reader->size - reader->end);
+	if (ret > 0) {
+		reader->end += ret;
+	}
+	return ret;
+}
+
+/**
+ * Gets at least count bytes without consuming them.
+ *
+ * @param reader Pointer to the reader
+ * @param count Minimum number of bytes to get (at most the window size)
+ * @param data Pointer where to store the address of buffered bytes
+ *
+ * @return Number of bytes available at data (count or more), or -1 if an error occurs or end of file is reached
+ */
+ssize_t rn_bufreader_peek(rn_bufreader_t *reader, size_t count, char **data)
+{
+	XASSERT(reader != NULL, -1);
+	XASSERT(data != NULL, -1);
+	XASSERT(count <= reader->size, -1);
+
+	while (reader->end - reader->start < count) {
+		if (rn_bufreader_fill(reader) <= 0) {
+			return -1;
+		}
+	}
+	*data = reader->buf + reader->start;
+	return reader->end - reader->start;
+}
+
+/**
+ * Consumes buffered bytes.
+ *
+ * @param reader Pointer to the reader
+ * @param count Number of bytes to consume (at most rn_bufreader_buffered)
+ */
+void rn_bufreader_consume(rn_bufreader_t *reader, size_t count)
+{
+	XASSERTN(reader != NULL);
+	XASSERTN(count <= reader->end - reader->start);
+
+	reader->start += count;
+}
+
+/**
+ * Reads data until a delimiter is found.
+ * Data is returned in place, it remains valid until the next call on this reader.
+ * Bytes already scanned are not scanned again when more data is needed.
+ *
+ * @param reader Pointer to the reader
+ * @param delim Delimiter
+ * @param maxsize Maximum size of data, delimiter included (capped by the window size)
+ * @param data Pointer where to store the address of data read
+ *
+ * @return Size of data read, delimiter included, or -1 if an error occurs (EMSGSIZE if maxsize is reached)
+ */
+ssize_t rn_bufreader_read_until(rn_bufreader_t *reader, const char *delim, size_t maxsize, char **data)
+{
+	char *ptr;
+	size_t len;
+	size_t dlen;
+	size_t offset;
+	size_t avail;
+
+	XASSERT(reader != NULL, -1);
+	XASSERT(delim != NULL && delim[0] != '\0', -1);
+	XASSERT(data != NULL, -1);
+
+	dlen = strlen(delim);
+	if (maxsize == 0 || maxsize > reader->size) {
+		maxsize = reader->size;
+	}
+	offset = 0;
+	while (1) {
+		avail = reader->end - reader->start;
+		if (avail >= offset + dlen) {
+			ptr = memmem(reader->buf + reader->start + offset, avail - offset, delim, dlen);
+			if (ptr != NULL) {
+				len = ptr - (reader->buf + reader->start) + dlen;
+				if (len > maxsize) {
+					break;
+				}
+				*data = reader->buf + reader->start;
+				reader->start += len;
+				return len;
+			}
+			/* The delimiter may start in the last dlen - 1 bytes */
+			offset = avail - dlen + 1;
+		}
+		if (avail >= maxsize) {
+			break;
+		}
+		if (rn_bufreader_fill(reader) <= 0) {
+			return -1;
+		}
+	}
+	rn_error_set(EMSGSIZE);
+	return -1;
+}
+
+/**
+ * Reads a line terminated by "\n" (or "\r\n").
+ * The line is returned in place without its terminator, it remains valid
+ * until the next call on this reader.
+ *
+ * @param reader Pointer to the reader
+ * @param maxsize Maximum line size, terminator included (capped by the window size)
+ * @param line Pointer where to store the address of the line
+ *
+ * @return Line size, terminator excluded, or -1 if an error occurs
+ */
+ssize_t rn_bufreader_readline(rn_bufreader_t *reader, size_t maxsize, char **line)
+{
+	ssize_t len;
+
+	len = rn_bufreader_read_until(reader, "\n", maxsize, line);
+	if (len < 0) {
+		return -1;
+	}
+	len--;
+	if (len > 0 && (*line)[len - 1] == '\r') {
+		len--;
+	}
+	return len;
+}
+
+/**
+ * Reads exactly count bytes.
+ * Buffered bytes are copied first, then large remainders are read straight
+ * into the destination instead of going through the window.
+ *
+ * @param reader Pointer to the reader
+ * @param buf Destination buffer
+ * @param count Number of bytes to read
+ *
+ * @return count on success or -1 if an error occurs or end of file is reached before
+ */
+ssize_t rn_bufreader_read_exact(rn_bufreader_t *reader, void *buf, size_t count)
+{
+	size_t len;
+	size_t done;
+	ssize_t ret;
+
+	XASSERT(reader != NULL, -1);
+	XASSERT(buf != NULL, -1);
+
+	done = 0;
+	while (done < count) {
+		if (reader->start == reader->end) {
+			if (count - done >= reader->size) {
+				ret = rn_socket_read(reader->socket, buf + done, count - done);
+				if (ret <= 0) {
+					return -1;
+				}
+				done += ret;
+				continue;
+			}
+			if (rn_bufreader_fill(reader) <= 0) {
+				return -1;
+			}
+		}
+		len = reader->end - reader->start;
+		if (len > count - done) {
+			len = count - done;
+		}
+		memcpy(buf + done, reader->buf + reader->start, len);
+		reader->start += len;
+		done += len;
+	}
+	return count;
+}
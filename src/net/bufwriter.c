@@ -0,0 +1,234 @@
+/**
+ * @file   bufwriter.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Buffered socket writer
+ *
+ *
+ */
+
+#include "rinoo/net/module.h"
+
+/**
+ * Sends buffered data without waiting for the socket.
+ * This is only possible for sockets writing their file descriptor as-is,
+ * other sockets (like SSL or rate limited ones) are flushed instead.
+ *
+ * @param writer Pointer to the writer
+ *
+ * @return 0 on success (data may remain buffered) or -1 if an error occurs
+ */
+static int rn_bufwriter_drain(rn_bufwriter_t *writer)
+{
+	ssize_t ret;
+
+	if (writer->socket->class->write != rn_socket_class_tcp_write ||
+	    (writer->socket->flags & RN_SOCKET_FLAG_RATELIMIT)) {
+		return rn_bufwriter_flush(writer);
+	}
+	if (writer->len == 0) {
+		return 0;
+	}
+	ret = rn_socket_stat_out(writer->socket, send(writer->socket->node.fd, writer->buf, writer->len, MSG_DONTWAIT | MSG_NOSIGNAL));
+	if (ret < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return 0;
+		}
+		rn_error_set(errno);
+		return -1;
+	}
+	writer->len -= ret;
+	if (writer->len > 0) {
+		memmove(writer->buf, writer->buf + ret, writer->len);
+	}
+	return 0;
+}
+
+/**
+ * Task hook sending buffered data when the writing task yields.
+ *
+ * @param hook Pointer to the writer hook
+ */
+static void rn_bufwriter_yield(rn_task_hook_t *hook)
+{
+	rn_bufwriter_t *writer = container_of(hook, rn_bufwriter_t, hook);
+
+	if (writer->flushing || writer->len == 0) {
+		return;
+	}
+	if (writer->socket->class->write == rn_socket_class_tcp_write &&
+	    (writer->socket->flags & RN_SOCKET_FLAG_RATELIMIT) == 0) {
+		/* Errors are reported by the next write or flush */
+		rn_bufwriter_drain(writer);
+	}
+}
+
+/**
+ * Initializes a buffered writer on a socket.
+ * Small writes are gathered and sent once threshold bytes are buffered,
+ * when the task yields (e.g. waiting for the peer), or on rn_bufwriter_flush.
+ * When the peer reads slowly, data keeps being buffered up to highwater bytes,
+ * then the writing task is suspended until the kernel drains it.
+ * The writer must be used and destroyed by the task which initialized it.
+ *
+ * @param writer Pointer to the writer to initialize
+ * @param socket Socket to write to
+ * @param threshold Size triggering a send (RN_BUFWRITER_THRESHOLD if 0)
+ * @param highwater Maximum buffered size (RN_BUFWRITER_HIGHWATER if 0, at least threshold)
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_bufwriter(rn_bufwriter_t *writer, rn_socket_t *socket, size_t threshold, size_t highwater)
+{
+	XASSERT(writer != NULL, -1);
+	XASSERT(socket != NULL, -1);
+
+	writer->threshold = (threshold != 0 ? threshold : RN_BUFWRITER_THRESHOLD);
+	writer->highwater = (highwater != 0 ? highwater : RN_BUFWRITER_HIGHWATER);
+	if (writer->highwater < writer->threshold) {
+		writer->highwater = writer->threshold;
+	}
+	writer->buf = malloc(writer->threshold);
+	if (unlikely(writer->buf == NULL)) {
+		rn_error_set(errno);
+		return -1;
+	}
+	writer->msize = writer->threshold;
+	writer->len = 0;
+	writer->flushing = false;
+	writer->socket = socket;
+	writer->task = rn_task_driver_getcurrent(socket->node.sched);
+	rn_task_hook(writer->task, &writer->hook, rn_bufwriter_yield);
+	return 0;
+}
+
+/**
+ * Frees a buffered writer. Data not flushed is lost, the socket is left open.
+ *
+ * @param writer Pointer to the writer to destroy
+ */
+void rn_bufwriter_destroy(rn_bufwriter_t *writer)
+{
+	XASSERTN(writer != NULL);
+
+	rn_task_unhook(writer->task, &writer->hook);
+	free(writer->buf);
+	writer->buf = NULL;
+	writer->len = 0;
+}
+
+/**
+ * Gets the number of bytes buffered and not sent yet.
+ *
+ * @param writer Pointer to the writer
+ *
+ * @return Number of pending bytes
+ */
+size_t rn_bufwriter_pending(rn_bufwriter_t *writer)
+{
+	return writer->len;
+}
+
+/**
+ * Sends all buffered data, waiting for the socket if needed.
+ *
+ * @param writer Pointer to the writer
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_bufwriter_flush(rn_bufwriter_t *writer)
+{
+	ssize_t ret;
+
+	XASSERT(writer != NULL, -1);
+
+	if (writer->len == 0) {
+		return 0;
+	}
+	writer->flushing = true;
+	ret = rn_socket_write(writer->socket, writer->buf, writer->len);
+	writer->flushing = false;
+	if (ret != (ssize_t) writer->len) {
+		return -1;
+	}
+	writer->len = 0;
+	return 0;
+}
+
+/**
+ * Appends data to a buffered writer.
+ *
+ * @param writer Pointer to the writer
+ * @param buf Data to write
+ * @param count Data size
+ *
+ * @return count on success or -1 if an error occurs
+ */
+ssize_t rn_bufwriter_write(rn_bufwriter_t *writer, const void *buf, size_t count)
+{
+	char *tmp;
+	size_t msize;
+	ssize_t ret;
+
+	XASSERT(writer != NULL, -1);
+	XASSERT(buf != NULL, -1);
+
+	if (writer->len + count > writer->highwater) {
+		/* Backpressure: wait for the kernel to drain buffered data */
+		if (rn_bufwriter_flush(writer) != 0) {
+			return -1;
+		}
+		if (count >= writer->threshold) {
+			writer->flushing = true;
+			ret = rn_socket_write(writer->socket, buf, count);
+			writer->flushing = false;
+			return ret;
+		}
+	}
+	if (writer->len + count > writer->msize) {
+		for (msize = writer->msize; msize < writer->len + count; msize *= 2);
+		if (msize > writer->highwater) {
+			msize = writer->highwater;
+		}
+		tmp = realloc(writer->buf, msize);
+		if (unlikely(tmp == NULL)) {
+			rn_error_set(errno);
+			return -1;
+		}
+		writer->buf = tmp;
+		writer->msize = msize;
+	}
+	memcpy(writer->buf + writer->len, buf, count);
+	writer->len += count;
+	if (writer->len >= writer->threshold && rn_bufwriter_drain(writer) != 0) {
+		return -1;
+	}
+	return count;
+}
+
+/**
+ * Appends a buffer content to a buffered writer.
+ *
+ * @param writer Pointer to the writer
+ * @param buffer Buffer to write
+ *
+ * @return Buffer size on success or -1 if an error occurs
+ */
+ssize_t rn_bufwriter_writeb(rn_bufwriter_t *writer, rn_buffer_t *buffer)
+{
+	return rn_bufwriter_write(writer, rn_buffer_ptr(buffer), rn_buffer_size(buffer));
+}
+
+/**
+ * Appends a string to a buffered writer.
+ *
+ * @param writer Pointer to the writer
+ * @param str String to write
+ *
+ * @return String length on success or -1 if an error occurs
+ */
+ssize_t rn_bufwriter_writestr(rn_bufwriter_t *writer, const char *str)
+{
+	return rn_bufwriter_write(writer, str, strlen(str));
+}
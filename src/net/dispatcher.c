@@ -0,0 +1,406 @@
+/**
+ * @file   dispatcher.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Connection dispatching across spawned schedulers
+ *
+ *
+ */
+
+#include "rinoo/net/module.h"
+
+/**
+ * Releases a reference on a dispatcher and frees it
+ * once the last reference is gone.
+ *
+ * @param dispatcher Pointer to the dispatcher to release
+ */
+static void rn_dispatcher_release(rn_dispatcher_t *dispatcher)
+{
+	int i;
+
+	if (__atomic_sub_fetch(&dispatcher->refs, 1, __ATOMIC_ACQ_REL) > 0) {
+		return;
+	}
+	for (i = 0; i < dispatcher->count; i++) {
+		if (dispatcher->workers[i].event != NULL) {
+			rn_fd_destroy(dispatcher->workers[i].event);
+		}
+		pthread_mutex_destroy(&dispatcher->workers[i].mutex);
+	}
+	free(dispatcher->workers);
+	free(dispatcher);
+}
+
+/**
+ * Task running a dispatched connection on its new scheduler.
+ *
+ * @param arg Pointer to the dispatch job
+ */
+static void rn_dispatcher_job(void *arg)
+{
+	rn_socket_t *socket;
+	rn_dispatch_job_t *job = arg;
+	rn_dispatch_worker_t *worker = job->worker;
+	rn_dispatcher_t *dispatcher = worker->dispatcher;
+
+	socket = job->socket;
+	free(job);
+	dispatcher->handler(socket, dispatcher->arg);
+	__atomic_sub_fetch(&worker->gauges.conns, 1, __ATOMIC_RELAXED);
+	rn_dispatcher_release(dispatcher);
+}
+
+/**
+ * Drops a dispatch job which could not be run.
+ *
+ * @param job Pointer to the job to drop
+ */
+static void rn_dispatcher_job_drop(rn_dispatch_job_t *job)
+{
+	rn_dispatch_worker_t *worker = job->worker;
+
+	rn_socket_destroy(job->socket);
+	__atomic_sub_fetch(&worker->gauges.conns, 1, __ATOMIC_RELAXED);
+	rn_dispatcher_release(worker->dispatcher);
+	free(job);
+}
+
+/**
+ * Worker task. It waits for connections queued by the dispatcher
+ * and starts a task for each of them on its scheduler.
+ *
+ * @param arg Pointer to the dispatcher worker
+ */
+static void rn_dispatcher_worker(void *arg)
+{
+	uint64_t value;
+	rn_list_node_t *node;
+	rn_dispatch_job_t *job;
+	rn_dispatch_worker_t *worker = arg;
+
+	while (rn_eventfd_read(worker->event, &value) == 0) {
+		pthread_mutex_lock(&worker->mutex);
+		while ((node = rn_list_pop(&worker->queue)) != NULL) {
+			job = container_of(node, rn_dispatch_job_t, lnode);
+			if (rn_task_start(worker->sched, rn_dispatcher_job, job) != 0) {
+				rn_dispatcher_job_drop(job);
+			}
+		}
+		pthread_mutex_unlock(&worker->mutex);
+	}
+	/* Scheduler is stopping, no more connections can be queued */
+	pthread_mutex_lock(&worker->mutex);
+	/* Last loop lag, the scheduler is freed once stopped */
+	worker->gauges.lag = worker->sched->lag;
+	worker->running = false;
+	while ((node = rn_list_pop(&worker->queue)) != NULL) {
+		rn_dispatcher_job_drop(container_of(node, rn_dispatch_job_t, lnode));
+	}
+	rn_fd_destroy(worker->event);
+	worker->event = NULL;
+	pthread_mutex_unlock(&worker->mutex);
+	rn_dispatcher_release(worker->dispatcher);
+}
+
+/**
+ * Gets the loop lag of a worker scheduler, as measured by rn_scheduler_poll.
+ *
+ * @param worker Pointer to the dispatcher worker
+ *
+ * @return Loop lag in microseconds
+ */
+static uint32_t rn_dispatcher_lag(rn_dispatch_worker_t *worker)
+{
+	uint32_t lag;
+
+	pthread_mutex_lock(&worker->mutex);
+	if (worker->running) {
+		lag = __atomic_load_n(&worker->sched->lag, __ATOMIC_RELAXED);
+	} else {
+		lag = worker->gauges.lag;
+	}
+	pthread_mutex_unlock(&worker->mutex);
+	return lag;
+}
+
+/**
+ * Creates a connection dispatcher over a scheduler and its spawns.
+ * A worker is created on every scheduler, including sched itself.
+ * This must be called after rn_spawn and before running the scheduler loop.
+ * Workers keep their scheduler running until it gets stopped.
+ *
+ * @param sched Pointer to the main scheduler
+ * @param policy Policy used to select a scheduler for each connection
+ * @param handler Function to run, as a task, for each dispatched connection
+ * @param arg Argument passed to handler
+ *
+ * @return Pointer to the new dispatcher, or NULL if an error occurs
+ */
+rn_dispatcher_t *rn_dispatcher(rn_sched_t *sched, rn_dispatch_policy_t policy, void (*handler)(rn_socket_t *socket, void *arg), void *arg)
+{
+	int i;
+	rn_dispatch_worker_t *worker;
+	rn_dispatcher_t *dispatcher;
+
+	XASSERT(sched != NULL, NULL);
+	XASSERT(handler != NULL, NULL);
+
+	dispatcher = calloc(1, sizeof(*dispatcher));
+	if (unlikely(dispatcher == NULL)) {
+		rn_error_set(errno);
+		return NULL;
+	}
+	dispatcher->count = sched->spawns.count + 1;
+	dispatcher->workers = calloc(dispatcher->count, sizeof(*dispatcher->workers));
+	if (unlikely(dispatcher->workers == NULL)) {
+		rn_error_set(errno);
+		free(dispatcher);
+		return NULL;
+	}
+	dispatcher->refs = 1;
+	dispatcher->arg = arg;
+	dispatcher->policy = policy;
+	dispatcher->handler = handler;
+	for (i = 0; i < dispatcher->count; i++) {
+		worker = &dispatcher->workers[i];
+		worker->dispatcher = dispatcher;
+		worker->sched = rn_spawn_get(sched, i);
+		pthread_mutex_init(&worker->mutex, NULL);
+		rn_list(&worker->queue, NULL);
+		if (worker->sched != NULL) {
+			worker->event = rn_eventfd(worker->sched, 0);
+		}
+		if (worker->event == NULL) {
+			dispatcher->count = i + 1;
+			rn_dispatcher_release(dispatcher);
+			return NULL;
+		}
+		worker->running = true;
+	}
+	for (i = 0; i < dispatcher->count; i++) {
+		worker = &dispatcher->workers[i];
+		dispatcher->refs++;
+		if (rn_task_start(worker->sched, rn_dispatcher_worker, worker) != 0) {
+			/* Tasks already started will stop with their scheduler */
+			dispatcher->refs--;
+			rn_dispatcher_release(dispatcher);
+			return NULL;
+		}
+	}
+	return dispatcher;
+}
+
+/**
+ * Releases a dispatcher.
+ * Memory is actually freed once all workers and dispatched
+ * connections are over, that is when their schedulers are stopped.
+ *
+ * @param dispatcher Pointer to the dispatcher to destroy
+ */
+void rn_dispatcher_destroy(rn_dispatcher_t *dispatcher)
+{
+	XASSERTN(dispatcher != NULL);
+
+	rn_dispatcher_release(dispatcher);
+}
+
+/**
+ * Sets a custom selection function, replacing the dispatcher policy.
+ * The function returns the id of the scheduler (0 for the main one)
+ * which should handle a connection. It is called from the accepting task.
+ *
+ * @param dispatcher Pointer to the dispatcher to use
+ * @param select Selection function, or NULL to use the dispatcher policy
+ */
+void rn_dispatcher_select(rn_dispatcher_t *dispatcher, int (*select)(rn_dispatcher_t *dispatcher, const rn_addr_t *from))
+{
+	XASSERTN(dispatcher != NULL);
+
+	dispatcher->select = select;
+}
+
+/**
+ * Gets load gauges of a dispatcher worker.
+ *
+ * @param dispatcher Pointer to the dispatcher to use
+ * @param id Scheduler id (0 for the main one)
+ * @param gauges Pointer to the gauges to fill
+ *
+ * @return 0 on success, or -1 if id is invalid
+ */
+int rn_dispatcher_gauges(rn_dispatcher_t *dispatcher, int id, rn_dispatch_gauges_t *gauges)
+{
+	rn_dispatch_worker_t *worker;
+
+	XASSERT(dispatcher != NULL, -1);
+	XASSERT(gauges != NULL, -1);
+	XASSERT(id >= 0 && id < dispatcher->count, -1);
+
+	worker = &dispatcher->workers[id];
+	gauges->conns = __atomic_load_n(&worker->gauges.conns, __ATOMIC_RELAXED);
+	gauges->lag = rn_dispatcher_lag(worker);
+	gauges->dispatched = __atomic_load_n(&worker->gauges.dispatched, __ATOMIC_RELAXED);
+	return 0;
+}
+
+/**
+ * Selects a worker for a connection, depending on dispatcher policy.
+ *
+ * @param dispatcher Pointer to the dispatcher to use
+ * @param from Peer address of the connection, can be NULL
+ *
+ * @return Worker id
+ */
+static int rn_dispatcher_pick(rn_dispatcher_t *dispatcher, const rn_addr_t *from)
+{
+	int i;
+	int id;
+	int best;
+	uint32_t lag;
+	uint32_t minlag;
+	uint32_t hash;
+	rn_dispatch_worker_t *cur;
+	rn_dispatch_worker_t *min;
+
+	if (dispatcher->select != NULL) {
+		return dispatcher->select(dispatcher, from);
+	}
+	if (dispatcher->policy == RN_DISPATCH_HASH && from != NULL) {
+		switch (from->sa.sa_family) {
+		case AF_INET:
+			murmurhash3_x86_32(&from->v4.sin_addr, sizeof(from->v4.sin_addr), 0, &hash);
+			return hash % dispatcher->count;
+		case AF_INET6:
+			murmurhash3_x86_32(&from->v6.sin6_addr, sizeof(from->v6.sin6_addr), 0, &hash);
+			return hash % dispatcher->count;
+		default:
+			/* No peer address to hash (unix sockets), use round robin */
+			break;
+		}
+	}
+	/* Round robin start point spreads ties between workers */
+	best = __atomic_fetch_add(&dispatcher->next, 1, __ATOMIC_RELAXED) % dispatcher->count;
+	if (dispatcher->policy != RN_DISPATCH_LEASTCONN && dispatcher->policy != RN_DISPATCH_LEASTLAG) {
+		return best;
+	}
+	minlag = 0;
+	if (dispatcher->policy == RN_DISPATCH_LEASTLAG) {
+		minlag = rn_dispatcher_lag(&dispatcher->workers[best]);
+	}
+	for (i = 1; i < dispatcher->count; i++) {
+		id = (best + i) % dispatcher->count;
+		cur = &dispatcher->workers[id];
+		min = &dispatcher->workers[best];
+		if (dispatcher->policy == RN_DISPATCH_LEASTLAG) {
+			lag = rn_dispatcher_lag(cur);
+			if (lag < minlag) {
+				best = id;
+				minlag = lag;
+				continue;
+			}
+			if (lag > minlag) {
+				continue;
+			}
+		}
+		if (__atomic_load_n(&cur->gauges.conns, __ATOMIC_RELAXED) < __atomic_load_n(&min->gauges.conns, __ATOMIC_RELAXED)) {
+			best = id;
+		}
+	}
+	return best;
+}
+
+/**
+ * Hands a connection over to one of the dispatcher schedulers.
+ * The socket must not be used by the calling task afterwards:
+ * it is moved to the selected scheduler where the dispatcher handler
+ * is run in a new task.
+ *
+ * @param dispatcher Pointer to the dispatcher to use
+ * @param socket Socket to dispatch
+ * @param from Peer address of the socket, can be NULL
+ *
+ * @return 0 on success, or -1 if an error occurs (the socket is left untouched)
+ */
+int rn_dispatcher_dispatch(rn_dispatcher_t *dispatcher, rn_socket_t *socket, const rn_addr_t *from)
+{
+	int id;
+	rn_sched_t *origin;
+	rn_dispatch_job_t *job;
+	rn_dispatch_worker_t *worker;
+
+	XASSERT(dispatcher != NULL, -1);
+	XASSERT(socket != NULL, -1);
+
+	id = rn_dispatcher_pick(dispatcher, from);
+	if (id < 0 || id >= dispatcher->count) {
+		rn_error_set(EINVAL);
+		return -1;
+	}
+	worker = &dispatcher->workers[id];
+	job = malloc(sizeof(*job));
+	if (unlikely(job == NULL)) {
+		rn_error_set(errno);
+		return -1;
+	}
+	job->socket = socket;
+	job->worker = worker;
+	/* Detach socket from its scheduler, it will be registered again by its new task */
+	origin = socket->node.sched;
+	rn_scheduler_remove(&socket->node);
+	socket->node.modes = RN_MODE_NONE;
+	socket->node.sched = worker->sched;
+	__atomic_add_fetch(&dispatcher->refs, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&worker->gauges.conns, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&worker->gauges.dispatched, 1, __ATOMIC_RELAXED);
+	if (worker->sched == rn_scheduler_self()) {
+		if (rn_task_start(worker->sched, rn_dispatcher_job, job) == 0) {
+			return 0;
+		}
+	} else {
+		pthread_mutex_lock(&worker->mutex);
+		if (worker->running == true) {
+			rn_list_put(&worker->queue, &job->lnode);
+			if (rn_eventfd_write(worker->event, 1) == 0) {
+				pthread_mutex_unlock(&worker->mutex);
+				return 0;
+			}
+			rn_list_remove(&worker->queue, &job->lnode);
+		} else {
+			rn_error_set(ECANCELED);
+		}
+		pthread_mutex_unlock(&worker->mutex);
+	}
+	socket->node.sched = origin;
+	__atomic_sub_fetch(&worker->gauges.conns, 1, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&worker->gauges.dispatched, 1, __ATOMIC_RELAXED);
+	rn_dispatcher_release(dispatcher);
+	free(job);
+	return -1;
+}
+
+/**
+ * Accepts connections on a server socket and dispatches them.
+ * This runs until accept fails, typically when the scheduler is stopped.
+ *
+ * @param dispatcher Pointer to the dispatcher to use
+ * @param server Listening socket
+ *
+ * @return -1 when accept has failed
+ */
+int rn_dispatcher_accept(rn_dispatcher_t *dispatcher, rn_socket_t *server)
+{
+	rn_addr_t from;
+	rn_socket_t *client;
+
+	XASSERT(dispatcher != NULL, -1);
+	XASSERT(server != NULL, -1);
+
+	while ((client = rn_socket_accept(server, &from)) != NULL) {
+		if (rn_dispatcher_dispatch(dispatcher, client, &from) != 0) {
+			rn_socket_destroy(client);
+		}
+	}
+	return -1;
+}
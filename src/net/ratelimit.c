@@ -0,0 +1,236 @@
+/**
+ * @file   ratelimit.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Socket bandwidth shaping
+ *
+ *
+ */
+
+#include "rinoo/net/module.h"
+
+/**
+ * Creates a token bucket which can be shared by a group of sockets.
+ * The bucket starts full. It is not thread safe: all sockets of a group
+ * must be run by the same scheduler.
+ *
+ * @param rate Rate in bytes per second
+ * @param burst Bucket size in bytes (rate if 0), that is the largest burst allowed
+ *
+ * @return Pointer to the new bucket or NULL if an error occurs
+ */
+rn_ratelimit_t *rn_ratelimit(uint64_t rate, uint64_t burst)
+{
+	rn_ratelimit_t *limit;
+
+	XASSERT(rate > 0, NULL);
+
+	limit = calloc(1, sizeof(*limit));
+	if (unlikely(limit == NULL)) {
+		rn_error_set(errno);
+		return NULL;
+	}
+	limit->rate = rate;
+	limit->burst = (burst != 0 ? burst : rate);
+	limit->tokens = limit->burst;
+	return limit;
+}
+
+/**
+ * Destroys a token bucket. Sockets of its group must be detached first.
+ *
+ * @param limit Pointer to the bucket to destroy
+ */
+void rn_ratelimit_destroy(rn_ratelimit_t *limit)
+{
+	free(limit);
+}
+
+/**
+ * Adds the tokens earned since the last refill to a bucket.
+ *
+ * @param limit Pointer to the bucket
+ * @param now Current time
+ */
+static void rn_ratelimit_refill(rn_ratelimit_t *limit, const struct timeval *now)
+{
+	uint64_t usec;
+	uint64_t added;
+	struct timeval diff;
+
+	if (!timerisset(&limit->last)) {
+		limit->last = *now;
+		return;
+	}
+	if (timercmp(now, &limit->last, <=)) {
+		return;
+	}
+	timersub(now, &limit->last, &diff);
+	usec = diff.tv_sec * 1000000ULL + diff.tv_usec;
+	added = (uint64_t) ((double) usec * limit->rate / 1000000);
+	if (added == 0) {
+		/* Keep the elapsed time for the next refill */
+		return;
+	}
+	if (limit->tokens + (double) added >= (double) limit->burst) {
+		limit->tokens = limit->burst;
+	} else {
+		limit->tokens += added;
+	}
+	limit->last = *now;
+}
+
+/**
+ * Gets the time needed for a bucket to hold enough tokens.
+ *
+ * @param limit Pointer to the bucket
+ * @param count Number of bytes to send
+ *
+ * @return Time to wait in microseconds, 0 if data can be sent now
+ */
+static uint64_t rn_ratelimit_delay(rn_ratelimit_t *limit, size_t count)
+{
+	int64_t needed;
+
+	/* Large writes go by bursts, datagrams larger than the bucket wait for a full bucket */
+	needed = (count < limit->burst ? (int64_t) count : (int64_t) limit->burst);
+	if (limit->tokens >= needed) {
+		return 0;
+	}
+	return (uint64_t) (((double) (needed - limit->tokens) * 1000000 + limit->rate - 1) / limit->rate);
+}
+
+/**
+ * Limits the sending rate of a socket (token bucket).
+ * Writes, sends and sendfile on the socket suspend the calling task until
+ * enough tokens have been earned. Large writes are split by bursts.
+ *
+ * @param socket Pointer to the socket
+ * @param rate Rate in bytes per second, 0 to remove the limit
+ * @param burst Bucket size in bytes (rate if 0)
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_socket_ratelimit(rn_socket_t *socket, uint64_t rate, uint64_t burst)
+{
+	XASSERT(socket != NULL, -1);
+
+	if (socket->ratelimit != NULL) {
+		rn_ratelimit_destroy(socket->ratelimit);
+		socket->ratelimit = NULL;
+	}
+	if (rate > 0) {
+		socket->ratelimit = rn_ratelimit(rate, burst);
+		if (socket->ratelimit == NULL) {
+			return -1;
+		}
+	}
+	if (socket->ratelimit != NULL || socket->ratelimit_group != NULL) {
+		socket->flags |= RN_SOCKET_FLAG_RATELIMIT;
+	} else {
+		socket->flags &= ~RN_SOCKET_FLAG_RATELIMIT;
+	}
+	return 0;
+}
+
+/**
+ * Attaches a socket to a group sharing a token bucket, like all sockets
+ * of a route or of a scheduler. A socket can have its own limit as well,
+ * data is then sent at the lowest of both rates.
+ *
+ * @param socket Pointer to the socket
+ * @param group Pointer to the group bucket (see rn_ratelimit), NULL to detach the socket
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_socket_ratelimit_group(rn_socket_t *socket, rn_ratelimit_t *group)
+{
+	XASSERT(socket != NULL, -1);
+
+	socket->ratelimit_group = group;
+	if (socket->ratelimit != NULL || socket->ratelimit_group != NULL) {
+		socket->flags |= RN_SOCKET_FLAG_RATELIMIT;
+	} else {
+		socket->flags &= ~RN_SOCKET_FLAG_RATELIMIT;
+	}
+	return 0;
+}
+
+/**
+ * Removes the limits of a socket, and frees its own bucket.
+ *
+ * @param socket Pointer to the socket
+ */
+void rn_socket_ratelimit_reset(rn_socket_t *socket)
+{
+	XASSERTN(socket != NULL);
+
+	rn_ratelimit_destroy(socket->ratelimit);
+	socket->ratelimit = NULL;
+	socket->ratelimit_group = NULL;
+	socket->flags &= ~RN_SOCKET_FLAG_RATELIMIT;
+}
+
+/**
+ * Suspends the calling task until a rate limited socket can send data.
+ * This is called by socket classes through rn_socket_throttle.
+ * A timeout set with rn_socket_timeout keeps running while the task waits.
+ *
+ * @param socket Pointer to the socket
+ * @param count Number of bytes to send
+ *
+ * @return Number of bytes which can be sent now (at most count), or -1 if an error occurs (ETIMEDOUT on socket timeout)
+ */
+ssize_t rn_socket_ratelimit_wait(rn_socket_t *socket, size_t count)
+{
+	uint64_t delay;
+	uint64_t group;
+	struct timeval now;
+
+	while (1) {
+		rn_scheduler_now(socket->node.sched, &now);
+		delay = 0;
+		if (socket->ratelimit != NULL) {
+			rn_ratelimit_refill(socket->ratelimit, &now);
+			delay = rn_ratelimit_delay(socket->ratelimit, count);
+		}
+		if (socket->ratelimit_group != NULL) {
+			rn_ratelimit_refill(socket->ratelimit_group, &now);
+			group = rn_ratelimit_delay(socket->ratelimit_group, count);
+			if (group > delay) {
+				delay = group;
+			}
+		}
+		if (delay == 0) {
+			break;
+		}
+		if (rn_task_delay_us(socket->node.sched, delay) != 0) {
+			return -1;
+		}
+	}
+	if (socket->ratelimit != NULL && (int64_t) count > socket->ratelimit->tokens) {
+		count = socket->ratelimit->tokens;
+	}
+	if (socket->ratelimit_group != NULL && (int64_t) count > socket->ratelimit_group->tokens) {
+		count = socket->ratelimit_group->tokens;
+	}
+	return count;
+}
+
+/**
+ * Takes tokens for data sent on a rate limited socket.
+ * This is called by socket classes through rn_socket_throttled.
+ *
+ * @param socket Pointer to the socket
+ * @param count Number of bytes sent
+ */
+void rn_socket_ratelimit_consume(rn_socket_t *socket, size_t count)
+{
+	if (socket->ratelimit != NULL) {
+		socket->ratelimit->tokens -= count;
+	}
+	if (socket->ratelimit_group != NULL) {
+		socket->ratelimit_group->tokens -= count;
+	}
+}
@@ -51,6 +51,77 @@ int rn_addr6(rn_addr_t *dst, const char *src, uint16_t port)
 	return 0;
 }
 
+/**
+ * Set an rn_addr_t structure based off a unix socket path.
+ * A path starting with '@' is a name in the abstract namespace (without the '@'),
+ * which is not bound to the file system and disappears with the socket.
+ *
+ * @param dst Pointer to the rn_addr_t to set
+ * @param path Socket path, or abstract name prefixed by '@'
+ *
+ * @return 0 on success, otherwise -1
+ */
+int rn_addr_un(rn_addr_t *dst, const char *path)
+{
+	size_t len;
+
+	memset(dst, 0, sizeof(*dst));
+	dst->sa.sa_family = AF_UNIX;
+	len = strlen(path);
+	if (len >= sizeof(dst->un.sun_path)) {
+		rn_error_set(ENAMETOOLONG);
+		return -1;
+	}
+	memcpy(dst->un.sun_path, path, len);
+	if (path[0] == '@') {
+		dst->un.sun_path[0] = '\0';
+	}
+	return 0;
+}
+
+/**
+ * Gets the length of an address, as expected by the socket syscalls.
+ * Abstract unix names are not null-terminated, their length is part of the name.
+ *
+ * @param addr Pointer to the address
+ *
+ * @return Address length
+ */
+socklen_t rn_addr_len(const rn_addr_t *addr)
+{
+	switch (addr->sa.sa_family) {
+	case AF_INET:
+		return sizeof(addr->v4);
+	case AF_INET6:
+		return sizeof(addr->v6);
+	case AF_UNIX:
+		if (addr->un.sun_path[0] == '\0') {
+			return offsetof(struct sockaddr_un, sun_path) + 1 + strnlen(addr->un.sun_path + 1, sizeof(addr->un.sun_path) - 1);
+		}
+		return sizeof(addr->un);
+	}
+	return sizeof(*addr);
+}
+
+/**
+ * Sets socket class default options on a new socket.
+ *
+ * @param socket Socket pointer
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+static int rn_socket_defaults(rn_socket_t *socket)
+{
+	int i;
+
+	for (i = 0; i < RN_SOCKET_NBOPTS; i++) {
+		if (socket->class->options[i] != 0 && rn_socket_setopt(socket, i, socket->class->options[i]) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
 /**
  * Socket initialisation function.
  * Initializes a socket depending on socket class.
@@ -69,8 +140,10 @@ int rn_socket_init(rn_sched_t *sched, rn_socket_t *sock, const rn_socket_class_t
 
 	sock->class = class;
 	sock->node.sched = sched;
-	return class->open(sock);
-
+	if (class->open(sock) != 0) {
+		return -1;
+	}
+	return rn_socket_defaults(sock);
 }
 
 /**
@@ -133,8 +206,20 @@ void rn_socket_close(rn_socket_t *socket)
 	XASSERTN(socket != NULL);
 
 	rn_scheduler_remove(&socket->node);
+	if (socket->flags & RN_SOCKET_FLAG_CORKED) {
+		/* Pending data is sent by close */
+		rn_task_unhook(socket->cork_task, &socket->cork_hook);
+		socket->flags &= ~RN_SOCKET_FLAG_CORKED;
+		socket->cork_task = NULL;
+	}
 	socket->class->close(socket);
 	memset(&socket->node, 0, sizeof(socket->node));
+	if (socket->zerocopy != NULL) {
+		rn_tcp_zerocopy_destroy(socket);
+	}
+	if (socket->flags & RN_SOCKET_FLAG_RATELIMIT) {
+		rn_socket_ratelimit_reset(socket);
+	}
 }
 
 /**
@@ -150,6 +235,89 @@ void rn_socket_destroy(rn_socket_t *socket)
 	socket->class->destroy(socket);
 }
 
+/**
+ * Accounts an I/O syscall on a socket and its scheduler.
+ * This is called by socket classes through rn_socket_stat_in and
+ * rn_socket_stat_out, only when I/O accounting is enabled.
+ *
+ * @param socket Pointer to the socket
+ * @param mode RN_MODE_IN for a read, RN_MODE_OUT for a write
+ * @param ret Syscall return value (bytes transferred, or -1 with errno set)
+ */
+void rn_socket_stats_io(rn_socket_t *socket, rn_sched_mode_t mode, ssize_t ret)
+{
+	rn_stats_t *total = &socket->node.sched->stats.total;
+
+	if (mode == RN_MODE_IN) {
+		socket->stats.reads++;
+		total->reads++;
+		if (ret > 0) {
+			socket->stats.bytes_in += ret;
+			total->bytes_in += ret;
+		}
+	} else {
+		socket->stats.writes++;
+		total->writes++;
+		if (ret > 0) {
+			socket->stats.bytes_out += ret;
+			total->bytes_out += ret;
+		}
+	}
+	if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+		socket->stats.eagain++;
+		total->eagain++;
+	}
+}
+
+/**
+ * Waits for a socket to be available, accounting the wait and the time
+ * spent suspended (measured with the scheduler clock).
+ *
+ * @param socket Pointer to the socket to wait for
+ * @param mode Mode to wait for
+ *
+ * @return 0 on success or -1 if an error occurs (timeout is considered as error)
+ */
+static int rn_socket_stats_wait(rn_socket_t *socket, rn_sched_mode_t mode)
+{
+	int ret;
+	uint64_t elapsed;
+	struct timeval start;
+	struct timeval diff;
+	rn_sched_t *sched = socket->node.sched;
+
+	if (mode == RN_MODE_IN) {
+		socket->stats.waitin++;
+		sched->stats.total.waitin++;
+	} else {
+		socket->stats.waitout++;
+		sched->stats.total.waitout++;
+	}
+	start = sched->clock;
+	ret = rn_scheduler_waitfor(&socket->node, mode);
+	timersub(&sched->clock, &start, &diff);
+	elapsed = diff.tv_sec * 1000000ULL + diff.tv_usec;
+	socket->stats.suspended += elapsed;
+	sched->stats.total.suspended += elapsed;
+	return ret;
+}
+
+/**
+ * Gets I/O counters of a socket.
+ * Counters are only updated while accounting is enabled on the socket
+ * scheduler (see rn_scheduler_stats_enable).
+ *
+ * @param socket Pointer to the socket
+ *
+ * @return Pointer to the socket counters
+ */
+const rn_stats_t *rn_socket_stats(rn_socket_t *socket)
+{
+	XASSERT(socket != NULL, NULL);
+
+	return &socket->stats;
+}
+
 /**
  * Releases socket execution and waits for the socket to be available for read operations.
  *
@@ -160,6 +328,9 @@ void rn_socket_destroy(rn_socket_t *socket)
 int rn_socket_waitin(rn_socket_t *socket)
 {
 	socket->io_calls = 0;
+	if (rn_stats_enabled(socket->node.sched)) {
+		return rn_socket_stats_wait(socket, RN_MODE_IN);
+	}
 	return rn_scheduler_waitfor(&socket->node, RN_MODE_IN);
 }
 
@@ -173,6 +344,9 @@ int rn_socket_waitin(rn_socket_t *socket)
 int rn_socket_waitout(rn_socket_t *socket)
 {
 	socket->io_calls = 0;
+	if (rn_stats_enabled(socket->node.sched)) {
+		return rn_socket_stats_wait(socket, RN_MODE_OUT);
+	}
 	return rn_scheduler_waitfor(&socket->node, RN_MODE_OUT);
 }
 
@@ -205,21 +379,236 @@ int rn_socket_waitio(rn_socket_t *socket)
  * @return 0 on success or -1 if an error occurs
  */
 int rn_socket_timeout(rn_socket_t *socket, uint32_t ms)
+{
+	return rn_socket_timeout_us(socket, (uint64_t) ms * 1000);
+}
+
+/**
+ * Schedules a socket to be waken up, with microsecond precision.
+ *
+ * @param socket Socket pointer
+ * @param us Timeout in microseconds
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_socket_timeout_us(rn_socket_t *socket, uint64_t us)
 {
 	struct timeval res;
 	struct timeval toadd;
 
 	XASSERT(socket != NULL, -1);
 
-	if (ms == 0) {
+	if (us == 0) {
 		return rn_task_schedule(rn_task_driver_getcurrent(socket->node.sched), NULL);
 	}
-	toadd.tv_sec = ms / 1000;
-	toadd.tv_usec = (ms % 1000) * 1000;
+	toadd.tv_sec = us / 1000000;
+	toadd.tv_usec = us % 1000000;
 	timeradd(&socket->node.sched->clock, &toadd, &res);
 	return rn_task_schedule(rn_task_driver_getcurrent(socket->node.sched), &res);
 }
 
+/**
+ * Sets read, write and idle deadlines of a socket.
+ * Unlike rn_socket_timeout, which bounds the whole task, deadlines belong
+ * to the socket: a read (resp. write) fails with ETIMEDOUT when the socket
+ * is not readable (resp. writable) within read_ms (resp. write_ms), and any
+ * operation fails once the socket has seen no I/O for idle_ms.
+ *
+ * @param socket Socket pointer
+ * @param read_ms Read timeout in milliseconds, 0 to disable
+ * @param write_ms Write timeout in milliseconds, 0 to disable
+ * @param idle_ms Idle timeout in milliseconds, 0 to disable
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_socket_deadline(rn_socket_t *socket, uint32_t read_ms, uint32_t write_ms, uint32_t idle_ms)
+{
+	XASSERT(socket != NULL, -1);
+
+	return rn_scheduler_deadline(&socket->node, read_ms, write_ms, idle_ms);
+}
+
+/**
+ * Gets the setsockopt(2) level and name of a socket option.
+ *
+ * @param opt Socket option
+ * @param level Pointer where to store the option level
+ * @param name Pointer where to store the option name
+ *
+ * @return 0 on success or -1 if the option has no system counterpart
+ */
+static int rn_socket_optname(rn_socket_opt_t opt, int *level, int *name)
+{
+	switch (opt) {
+	case RN_SOCKET_NODELAY:
+		*level = IPPROTO_TCP;
+		*name = TCP_NODELAY;
+		return 0;
+	case RN_SOCKET_CORK:
+		*level = IPPROTO_TCP;
+		*name = TCP_CORK;
+		return 0;
+	case RN_SOCKET_NOTSENT_LOWAT:
+		*level = IPPROTO_TCP;
+		*name = TCP_NOTSENT_LOWAT;
+		return 0;
+	case RN_SOCKET_SNDBUF:
+		*level = SOL_SOCKET;
+		*name = SO_SNDBUF;
+		return 0;
+	case RN_SOCKET_RCVBUF:
+		*level = SOL_SOCKET;
+		*name = SO_RCVBUF;
+		return 0;
+	case RN_SOCKET_DEFER_ACCEPT:
+		*level = IPPROTO_TCP;
+		*name = TCP_DEFER_ACCEPT;
+		return 0;
+	case RN_SOCKET_FASTOPEN:
+		*level = IPPROTO_TCP;
+		*name = TCP_FASTOPEN;
+		return 0;
+	default:
+		break;
+	}
+	rn_error_set(EINVAL);
+	return -1;
+}
+
+/**
+ * Task hook uncorking a socket when the task which corked it yields.
+ * Data written before waiting for anything else is sent right away,
+ * instead of being held until the kernel cork timeout.
+ *
+ * @param hook Pointer to the socket cork hook
+ */
+static void rn_socket_cork_yield(rn_task_hook_t *hook)
+{
+	int disabled;
+	rn_socket_t *socket = container_of(hook, rn_socket_t, cork_hook);
+
+	disabled = 0;
+	setsockopt(socket->node.fd, IPPROTO_TCP, TCP_CORK, &disabled, sizeof(disabled));
+	socket->flags &= ~RN_SOCKET_FLAG_CORKED;
+	rn_task_unhook(socket->cork_task, hook);
+	socket->cork_task = NULL;
+}
+
+/**
+ * Corks a socket before writing, when in auto-cork mode.
+ * The socket gets uncorked when the writing task yields or ends.
+ *
+ * @param socket Socket pointer
+ */
+static inline void rn_socket_cork(rn_socket_t *socket)
+{
+	int enabled;
+	rn_task_t *task;
+
+	if ((socket->flags & (RN_SOCKET_FLAG_AUTOCORK | RN_SOCKET_FLAG_CORKED)) == RN_SOCKET_FLAG_AUTOCORK) {
+		task = rn_task_driver_getcurrent(socket->node.sched);
+		if (task == &socket->node.sched->driver.main) {
+			/* Main task never yields, nothing would uncork the socket */
+			return;
+		}
+		enabled = 1;
+		if (setsockopt(socket->node.fd, IPPROTO_TCP, TCP_CORK, &enabled, sizeof(enabled)) == 0) {
+			socket->flags |= RN_SOCKET_FLAG_CORKED;
+			socket->cork_task = task;
+			rn_task_hook(task, &socket->cork_hook, rn_socket_cork_yield);
+		}
+	}
+}
+
+/**
+ * Uncorks a socket before reading, so that the last partial segment
+ * written is sent before waiting for the peer.
+ *
+ * @param socket Socket pointer
+ */
+static inline void rn_socket_uncork(rn_socket_t *socket)
+{
+	if (unlikely(socket->flags & RN_SOCKET_FLAG_CORKED)) {
+		rn_socket_cork_yield(&socket->cork_hook);
+	}
+}
+
+/**
+ * Sets a socket option.
+ * With RN_SOCKET_AUTOCORK, writes are corked until the socket is read again
+ * or the writing task yields, so that multi-part responses (headers then body)
+ * go out in full segments.
+ * Sockets accepted from a listening socket inherit this mode.
+ *
+ * @param socket Socket pointer
+ * @param opt Option to set
+ * @param value Option value (0 or 1 for flags, bytes for buffers and low water mark, seconds for defer accept,
+ *              queue length for fast open, which servers must enable explicitly)
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_socket_setopt(rn_socket_t *socket, rn_socket_opt_t opt, int value)
+{
+	int name;
+	int level;
+
+	XASSERT(socket != NULL, -1);
+
+	if (opt == RN_SOCKET_AUTOCORK) {
+		if (value != 0) {
+			socket->flags |= RN_SOCKET_FLAG_AUTOCORK;
+		} else {
+			socket->flags &= ~RN_SOCKET_FLAG_AUTOCORK;
+			return rn_socket_setopt(socket, RN_SOCKET_CORK, 0);
+		}
+		return 0;
+	}
+	if (rn_socket_optname(opt, &level, &name) != 0) {
+		return -1;
+	}
+	if (setsockopt(socket->node.fd, level, name, &value, sizeof(value)) != 0) {
+		rn_error_set(errno);
+		return -1;
+	}
+	if (opt == RN_SOCKET_CORK && value == 0) {
+		rn_socket_uncork(socket);
+	}
+	return 0;
+}
+
+/**
+ * Gets a socket option.
+ *
+ * @param socket Socket pointer
+ * @param opt Option to get
+ * @param value Pointer where to store the option value
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_socket_getopt(rn_socket_t *socket, rn_socket_opt_t opt, int *value)
+{
+	int name;
+	int level;
+	socklen_t size;
+
+	XASSERT(socket != NULL, -1);
+	XASSERT(value != NULL, -1);
+
+	if (opt == RN_SOCKET_AUTOCORK) {
+		*value = ((socket->flags & RN_SOCKET_FLAG_AUTOCORK) != 0);
+		return 0;
+	}
+	if (rn_socket_optname(opt, &level, &name) != 0) {
+		return -1;
+	}
+	size = sizeof(*value);
+	if (getsockopt(socket->node.fd, level, name, value, &size) != 0) {
+		rn_error_set(errno);
+		return -1;
+	}
+	return 0;
+}
+
 /**
  * Connects a socket if possible by socket class.
  *
@@ -255,6 +644,7 @@ int rn_socket_bind(rn_socket_t *socket, const rn_addr_t *dst, int backlog)
 
 /**
  * Accepts a new connection from a listening socket.
+ * This applies the scheduler admission control (see rn_scheduler_admission).
  *
  * @param socket Pointer to the socket which is listening to
  * @param from Address to peer socket
@@ -263,10 +653,38 @@ int rn_socket_bind(rn_socket_t *socket, const rn_addr_t *dst, int backlog)
  */
 rn_socket_t *rn_socket_accept(rn_socket_t *socket, rn_addr_t *from)
 {
+	rn_sched_t *sched;
+	rn_socket_t *new;
+
 	XASSERT(socket != NULL, NULL);
 	XASSERT(socket->class->accept != NULL, NULL);
 
-	return socket->class->accept(socket, from);
+	sched = socket->node.sched;
+	if (sched->admission.mode == RN_ADMISSION_PAUSE && rn_scheduler_overloaded(sched)) {
+		/* Leave the epoll set, pending connections stay in the kernel backlog */
+		sched->admission.paused++;
+		rn_scheduler_remove(&socket->node);
+		socket->node.modes = RN_MODE_NONE;
+		while (rn_scheduler_overloaded(sched)) {
+			/* Keeps a timeout set with rn_socket_timeout running */
+			if (rn_task_delay_us(sched, RN_ADMISSION_WAIT * 1000) != 0) {
+				return NULL;
+			}
+		}
+	}
+	while ((new = socket->class->accept(socket, from)) != NULL) {
+		if (sched->admission.mode != RN_ADMISSION_REJECT || !rn_scheduler_overloaded(sched)) {
+			break;
+		}
+		/* Reset connection instead of a graceful close */
+		sched->admission.rejected++;
+		setsockopt(new->node.fd, SOL_SOCKET, SO_LINGER, &(struct linger){ .l_onoff = 1, .l_linger = 0 }, sizeof(struct linger));
+		rn_socket_destroy(new);
+	}
+	if (new != NULL) {
+		new->flags |= (socket->flags & RN_SOCKET_FLAG_AUTOCORK);
+	}
+	return new;
 }
 
 /**
@@ -280,6 +698,7 @@ rn_socket_t *rn_socket_accept(rn_socket_t *socket, rn_addr_t *from)
  */
 ssize_t rn_socket_read(rn_socket_t *socket, void *buf, size_t count)
 {
+	rn_socket_uncork(socket);
 	return socket->class->read(socket, buf, count);
 }
 
@@ -297,6 +716,7 @@ ssize_t rn_socket_recvfrom(rn_socket_t *socket, void *buf, size_t count, rn_addr
 {
 	XASSERT(socket->class->recvfrom != NULL, -1);
 
+	rn_socket_uncork(socket);
 	return socket->class->recvfrom(socket, buf, count, from);
 }
 
@@ -311,6 +731,7 @@ ssize_t rn_socket_recvfrom(rn_socket_t *socket, void *buf, size_t count, rn_addr
  */
 ssize_t	rn_socket_write(rn_socket_t *socket, const void *buf, size_t count)
 {
+	rn_socket_cork(socket);
 	return socket->class->write(socket, buf, count);
 }
 
@@ -329,6 +750,7 @@ ssize_t	rn_socket_writev(rn_socket_t *socket, rn_buffer_t **buffers, int count)
 	ssize_t ret;
 	ssize_t total;
 
+	rn_socket_cork(socket);
 	if (socket->class->writev != NULL) {
 		return socket->class->writev(socket, buffers, count);
 	} else {
@@ -361,6 +783,43 @@ ssize_t rn_socket_sendto(rn_socket_t *socket, void *buf, size_t count, const rn_
 	return socket->class->sendto(socket, buf, count, dst);
 }
 
+/**
+ * Receives several datagrams at once, depending on socket class.
+ * For each message, buf and size must be set by the caller;
+ * len and addr are set with the datagram length and its source.
+ * This waits for at least one datagram.
+ *
+ * @param socket Pointer to the socket to read
+ * @param msgs Array of messages to fill
+ * @param count Number of messages
+ *
+ * @return The number of messages received on success or -1 if an error occurs
+ */
+int rn_socket_recvmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count)
+{
+	XASSERT(socket->class->recvmmsg != NULL, -1);
+
+	return socket->class->recvmmsg(socket, msgs, count);
+}
+
+/**
+ * Sends several datagrams at once, depending on socket class.
+ * For each message, buf and len must be set by the caller, as well
+ * as addr unless the socket is connected (addr family set to AF_UNSPEC).
+ *
+ * @param socket Pointer to the socket to write to
+ * @param msgs Array of messages to send
+ * @param count Number of messages
+ *
+ * @return The number of messages sent on success or -1 if an error occurs
+ */
+int rn_socket_sendmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count)
+{
+	XASSERT(socket->class->sendmmsg != NULL, -1);
+
+	return socket->class->sendmmsg(socket, msgs, count);
+}
+
 /**
  * Socket read interface for rn_buffer_t.
  * This function waits for and reads information available on the socket.
@@ -378,6 +837,7 @@ ssize_t rn_socket_readb(rn_socket_t *socket, rn_buffer_t *buffer)
 	if (rn_buffer_isfull(buffer) && rn_buffer_extend(buffer, rn_buffer_size(buffer)) != 0) {
 		return -1;
 	}
+	rn_socket_uncork(socket);
 	res = socket->class->read(socket,
 				  rn_buffer_ptr(buffer) + rn_buffer_size(buffer),
 				  rn_buffer_msize(buffer) - rn_buffer_size(buffer));
@@ -415,6 +875,7 @@ ssize_t rn_socket_readline(rn_socket_t *socket, rn_buffer_t *buffer, const char
 
 	offset = 0;
 	dlen = strlen(delim);
+	rn_socket_uncork(socket);
 	while (rn_buffer_size(buffer) < maxsize) {
 		if (rn_buffer_size(buffer) - offset >= dlen) {
 			ptr = memmem(rn_buffer_ptr(buffer) + offset, rn_buffer_size(buffer) - offset, delim, dlen);
@@ -479,6 +940,7 @@ ssize_t rn_socket_writeb(rn_socket_t *socket, rn_buffer_t *buffer)
 
 	total = 0;
 	len = rn_buffer_size(buffer);
+	rn_socket_cork(socket);
 	while (len > 0) {
 		res = socket->class->write(socket, rn_buffer_ptr(buffer) + rn_buffer_size(buffer) - len, len);
 		if (res <= 0) {
@@ -493,6 +955,7 @@ ssize_t rn_socket_writeb(rn_socket_t *socket, rn_buffer_t *buffer)
 /**
  * Send a file through a socket.
  * This function waits for the socket to be available for write operations and attempt to send file content.
+ * If the socket class can not send files, or refuses to with EOPNOTSUPP, the file is mapped and written.
  *
  * @param socket Pointer to the socket to write to
  * @param in_fd File descriptor of the file to send
@@ -503,21 +966,266 @@ ssize_t rn_socket_writeb(rn_socket_t *socket, rn_buffer_t *buffer)
  */
 ssize_t rn_socket_sendfile(rn_socket_t *socket, int in_fd, off_t offset, size_t count)
 {
-	if (unlikely(socket->class->sendfile == NULL)) {
-		void *ptr;
-		int pagesize;
-		ssize_t result;
-		rn_buffer_t dummy;
+	void *ptr;
+	int pagesize;
+	ssize_t result;
+	rn_buffer_t dummy;
 
-		pagesize = getpagesize();
-		ptr = mmap(NULL, count + (offset % pagesize), PROT_READ, MAP_PRIVATE, in_fd, pagesize * (offset / pagesize));
-		if (ptr == MAP_FAILED) {
-			return -1;
+	rn_socket_cork(socket);
+	if (likely(socket->class->sendfile != NULL)) {
+		result = socket->class->sendfile(socket, in_fd, offset, count);
+		if (result >= 0 || rn_error != EOPNOTSUPP) {
+			return result;
+		}
+	}
+	pagesize = getpagesize();
+	ptr = mmap(NULL, count + (offset % pagesize), PROT_READ, MAP_PRIVATE, in_fd, pagesize * (offset / pagesize));
+	if (ptr == MAP_FAILED) {
+		return -1;
+	}
+	rn_buffer_static(&dummy, ptr + (offset % pagesize), count);
+	result = rn_socket_writeb(socket, &dummy);
+	munmap(ptr, count + (offset % pagesize));
+	return result;
+}
+
+/**
+ * Checks whether a socket carries application data as-is on its file descriptor,
+ * in which case it can be used with splice(2).
+ *
+ * @param socket Socket pointer
+ *
+ * @return true if the socket can be spliced, false otherwise
+ */
+static bool rn_socket_splicable(rn_socket_t *socket)
+{
+	return (socket->class->read == rn_socket_class_tcp_read && socket->class->write == rn_socket_class_tcp_write);
+}
+
+/**
+ * Buffered version of rn_socket_splice, used when splice(2) can not be used.
+ *
+ * @param in Socket to read from
+ * @param out Socket to write to
+ * @param max Maximum number of bytes to move
+ *
+ * @return The number of bytes moved or -1 if an error occurs
+ */
+static ssize_t rn_socket_splice_copy(rn_socket_t *in, rn_socket_t *out, size_t max)
+{
+	void *buf;
+	ssize_t ret;
+
+	if (max > RN_SPLICE_BUFSIZE) {
+		max = RN_SPLICE_BUFSIZE;
+	}
+	buf = malloc(max);
+	if (unlikely(buf == NULL)) {
+		rn_error_set(errno);
+		return -1;
+	}
+	rn_error_set(0);
+	ret = rn_socket_read(in, buf, max);
+	if (ret < 0 && rn_error == 0) {
+		/* End of file, socket classes fail without setting an error */
+		ret = 0;
+	}
+	if (ret > 0 && rn_socket_write(out, buf, ret) != ret) {
+		ret = -1;
+	}
+	free(buf);
+	return ret;
+}
+
+/**
+ * Moves data from a socket to another without copying it to user space.
+ * Data read from in goes through a pipe taken from the scheduler pool with splice(2),
+ * and is fully written to out before returning. SSL sockets fall back to a buffered copy.
+ *
+ * @param in Socket to read from
+ * @param out Socket to write to
+ * @param max Maximum number of bytes to move
+ *
+ * @return The number of bytes moved, 0 if in reached end of file, or -1 if an error occurs
+ */
+ssize_t rn_socket_splice(rn_socket_t *in, rn_socket_t *out, size_t max)
+{
+	int fds[2];
+	ssize_t ret;
+	ssize_t len;
+	size_t moved;
+	size_t pending;
+
+	XASSERT(in != NULL, -1);
+	XASSERT(out != NULL, -1);
+	XASSERT(max > 0, -1);
+
+	if (!rn_socket_splicable(in) || !rn_socket_splicable(out)) {
+		return rn_socket_splice_copy(in, out, max);
+	}
+	if (rn_socket_waitio(in) != 0) {
+		return -1;
+	}
+	if (rn_pipe_get(in->node.sched, fds) != 0) {
+		return -1;
+	}
+	while ((ret = rn_socket_stat_in(in, splice(in->node.fd, NULL, fds[1], NULL, max, SPLICE_F_MOVE | SPLICE_F_NONBLOCK))) < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			rn_error_set(errno);
+			goto error;
+		}
+		if (rn_socket_waitin(in) != 0) {
+			goto error;
 		}
-		rn_buffer_static(&dummy, ptr + (offset % pagesize), count);
-		result = rn_socket_writeb(socket, &dummy);
-		munmap(ptr, count + (offset % pagesize));
-		return result;
 	}
-	return socket->class->sendfile(socket, in_fd, offset, count);
+	moved = ret;
+	pending = ret;
+	while (pending > 0) {
+		len = rn_socket_throttle(out, pending);
+		if (len < 0) {
+			goto error;
+		}
+		ret = rn_socket_throttled(out, rn_socket_stat_out(out, splice(fds[0], NULL, out->node.fd, NULL, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK)));
+		if (ret < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				rn_error_set(errno);
+				goto error;
+			}
+			if (rn_socket_waitout(out) != 0) {
+				goto error;
+			}
+			continue;
+		}
+		pending -= ret;
+	}
+	rn_pipe_release(in->node.sched, fds);
+	return moved;
+error:
+	rn_pipe_release(in->node.sched, fds);
+	return -1;
+}
+
+/**
+ * Relays one direction of a socket pair until end of file or error.
+ * End of file is forwarded to out by shutting down its write side.
+ * An error shuts down both sockets so the other direction stops too.
+ *
+ * @param in Socket to read from
+ * @param out Socket to write to
+ *
+ * @return 0 on end of file, or -1 if an error occurs
+ */
+static int rn_socket_relay_flow(rn_socket_t *in, rn_socket_t *out)
+{
+	ssize_t ret;
+
+	while ((ret = rn_socket_splice(in, out, RN_SPLICE_SIZE)) > 0) {
+		/* Data is moved until end of file or error */
+	}
+	if (ret < 0) {
+		shutdown(in->node.fd, SHUT_RDWR);
+		shutdown(out->node.fd, SHUT_RDWR);
+		return -1;
+	}
+	shutdown(out->node.fd, SHUT_WR);
+	return 0;
+}
+
+/**
+ * Releases a reference to a relay and frees it when unused.
+ *
+ * @param relay Pointer to the relay
+ */
+static void rn_socket_relay_release(rn_socket_relay_t *relay)
+{
+	relay->refs--;
+	if (relay->refs == 0) {
+		free(relay);
+	}
+}
+
+/**
+ * Task relaying data from the second socket of a relay to the first one.
+ *
+ * @param arg Pointer to the relay
+ */
+static void rn_socket_relay_task(void *arg)
+{
+	rn_socket_relay_t *relay = arg;
+
+	relay->error = rn_socket_relay_flow(relay->b, relay->a);
+	rn_socket_destroy(relay->a);
+	rn_socket_destroy(relay->b);
+	relay->done = true;
+	if (relay->task != NULL) {
+		rn_task_schedule(relay->task, NULL);
+	}
+	rn_socket_relay_release(relay);
+}
+
+/**
+ * Relays data in both directions between two sockets, as a proxy does.
+ * Data from a is sent to b by the calling task, while a new task sends data from b to a
+ * using duplicates of both sockets. This returns once both directions have ended.
+ * Sockets are not destroyed. This must be called from a task, and both sockets must belong
+ * to the same scheduler. SSL sockets are relayed with a buffered copy instead of splice(2).
+ *
+ * @param a First socket
+ * @param b Second socket
+ *
+ * @return 0 if both directions reached end of file, or -1 if an error occurs
+ */
+int rn_socket_relay(rn_socket_t *a, rn_socket_t *b)
+{
+	int ret;
+	rn_sched_t *sched;
+	rn_socket_relay_t *relay;
+
+	XASSERT(a != NULL, -1);
+	XASSERT(b != NULL, -1);
+	XASSERT(a->node.sched == b->node.sched, -1);
+	XASSERT(rn_task_self() != &a->node.sched->driver.main, -1);
+
+	if (a->class->dup == NULL || b->class->dup == NULL) {
+		rn_error_set(EOPNOTSUPP);
+		return -1;
+	}
+	sched = a->node.sched;
+	relay = calloc(1, sizeof(*relay));
+	if (unlikely(relay == NULL)) {
+		rn_error_set(errno);
+		return -1;
+	}
+	relay->a = rn_socket_dup(sched, a);
+	if (unlikely(relay->a == NULL)) {
+		free(relay);
+		return -1;
+	}
+	relay->b = rn_socket_dup(sched, b);
+	if (unlikely(relay->b == NULL)) {
+		rn_socket_destroy(relay->a);
+		free(relay);
+		return -1;
+	}
+	relay->refs = 2;
+	if (rn_task_start(sched, rn_socket_relay_task, relay) != 0) {
+		rn_socket_destroy(relay->a);
+		rn_socket_destroy(relay->b);
+		free(relay);
+		return -1;
+	}
+	ret = rn_socket_relay_flow(a, b);
+	while (!relay->done) {
+		relay->task = rn_task_self();
+		if (rn_task_release(sched) != 0) {
+			ret = -1;
+			break;
+		}
+	}
+	relay->task = NULL;
+	if (relay->error != 0) {
+		ret = -1;
+	}
+	rn_socket_relay_release(relay);
+	return ret;
 }
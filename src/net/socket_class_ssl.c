@@ -16,14 +16,16 @@ const rn_socket_class_t socket_class_ssl = {
 	.create = rn_socket_class_ssl_create,
 	.destroy = rn_socket_class_ssl_destroy,
 	.open = rn_socket_class_tcp_open,
-	.dup = NULL,
-	.close = rn_socket_class_tcp_close,
+	.dup = rn_socket_class_ssl_dup,
+	.close = rn_socket_class_ssl_close,
 	.read = rn_socket_class_ssl_read,
 	.recvfrom = NULL,
 	.write = rn_socket_class_ssl_write,
-	.writev = NULL,
+	.writev = rn_socket_class_ssl_writev,
 	.sendto = NULL,
-	.sendfile = NULL,
+	.sendfile = rn_socket_class_ssl_sendfile,
+	.recvmmsg = NULL,
+	.sendmmsg = NULL,
 	.connect = rn_socket_class_ssl_connect,
 	.bind = rn_socket_class_tcp_bind,
 	.accept = rn_socket_class_ssl_accept
@@ -35,19 +37,60 @@ const rn_socket_class_t socket_class_ssl6 = {
 	.create = rn_socket_class_ssl_create,
 	.destroy = rn_socket_class_ssl_destroy,
 	.open = rn_socket_class_tcp_open,
-	.dup = NULL,
-	.close = rn_socket_class_tcp_close,
+	.dup = rn_socket_class_ssl_dup,
+	.close = rn_socket_class_ssl_close,
 	.read = rn_socket_class_ssl_read,
 	.recvfrom = NULL,
 	.write = rn_socket_class_ssl_write,
-	.writev = NULL,
+	.writev = rn_socket_class_ssl_writev,
 	.sendto = NULL,
-	.sendfile = NULL,
+	.sendfile = rn_socket_class_ssl_sendfile,
+	.recvmmsg = NULL,
+	.sendmmsg = NULL,
 	.connect = rn_socket_class_ssl_connect,
 	.bind = rn_socket_class_tcp_bind,
 	.accept = rn_socket_class_ssl_accept
 };
 
+/**
+ * Checks whether OpenSSL handed record encryption over to the kernel
+ * once the handshake is done.
+ *
+ * @param ssl Pointer to the SSL socket
+ *
+ * @return true if kTLS is used for sending, false otherwise
+ */
+static bool rn_socket_class_ssl_ktls(rn_ssl_t *unused(ssl))
+{
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+	return (BIO_get_ktls_send(SSL_get_wbio(ssl->ssl)) > 0);
+#else
+	/* OpenSSL is too old or built without kTLS support */
+	return false;
+#endif /* !SSL_OP_ENABLE_KTLS */
+}
+
+/**
+ * Handles a failed SSL call.
+ * After SSL_ERROR_SSL or SSL_ERROR_SYSCALL, the connection can't be used anymore
+ * and must not be shut down. The OpenSSL error queue is per thread: it is cleared
+ * so that it does not affect the next SSL_get_error call of another connection.
+ *
+ * @param ssl Pointer to the SSL socket
+ * @param error SSL_get_error result
+ */
+static void rn_socket_class_ssl_failed(rn_ssl_t *ssl, int error)
+{
+	if (error == SSL_ERROR_SSL || error == SSL_ERROR_SYSCALL) {
+		/* Duplicates share the connection of their origin */
+		(ssl->origin != NULL ? ssl->origin : ssl)->fatal = true;
+	}
+	if (error == SSL_ERROR_SSL) {
+		rn_error_set(EPROTO);
+	}
+	ERR_clear_error();
+}
+
 /**
  * Allocates a secure socket.
  *
@@ -79,9 +122,76 @@ void rn_socket_class_ssl_destroy(rn_socket_t *socket)
 	if (ssl->ssl != NULL) {
 		SSL_free(ssl->ssl);
 	}
+	free(ssl->record);
 	free(ssl);
 }
 
+/**
+ * Duplicates a secure socket.
+ * The duplicate gets its own file descriptor to wait on, but shares the SSL
+ * connection of the socket: it must stay on the same scheduler, and it must be
+ * destroyed before the socket. Closing it does not end the SSL connection.
+ *
+ * @param destination Destination scheduler
+ * @param socket Socket to duplicate
+ *
+ * @return Pointer to the new socket or NULL if an error occurs
+ */
+rn_socket_t *rn_socket_class_ssl_dup(rn_sched_t *destination, rn_socket_t *socket)
+{
+	rn_ssl_t *new;
+	rn_ssl_t *ssl = rn_ssl_get(socket);
+
+	if (destination != socket->node.sched || ssl->ssl == NULL) {
+		rn_error_set(EINVAL);
+		return NULL;
+	}
+	new = calloc(1, sizeof(*new));
+	if (unlikely(new == NULL)) {
+		rn_error_set(errno);
+		return NULL;
+	}
+	new->ktls = ssl->ktls;
+	new->ctx = ssl->ctx;
+	new->origin = (ssl->origin != NULL ? ssl->origin : ssl);
+	new->socket.class = socket->class;
+	new->socket.parent = socket->parent;
+	new->socket.node.sched = destination;
+	new->socket.node.fd = dup(socket->node.fd);
+	if (unlikely(new->socket.node.fd < 0)) {
+		rn_error_set(errno);
+		free(new);
+		return NULL;
+	}
+	SSL_up_ref(ssl->ssl);
+	new->ssl = ssl->ssl;
+	return &new->socket;
+}
+
+/**
+ * Closes a secure socket.
+ * Client sessions are kept to be resumed by the next connection to the same peer.
+ * A close_notify alert is sent first, without waiting for the peer one. Otherwise,
+ * OpenSSL considers the connection truncated and the session could not be resumed.
+ *
+ * @param socket Socket pointer
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_socket_class_ssl_close(rn_socket_t *socket)
+{
+	rn_ssl_t *ssl = rn_ssl_get(socket);
+
+	if (ssl->ssl != NULL && ssl->origin == NULL && !ssl->fatal && SSL_is_init_finished(ssl->ssl)) {
+		if (!SSL_is_server(ssl->ssl)) {
+			rn_ssl_cache_client_store(ssl->ctx, ssl->ssl);
+		}
+		SSL_shutdown(ssl->ssl);
+		ERR_clear_error();
+	}
+	return rn_socket_class_tcp_close(socket);
+}
+
 /**
  * Replacement to the read(2) syscall in this library.
  * This function waits for the socket to be available for read operations and calls the read(2) syscall.
@@ -95,20 +205,23 @@ void rn_socket_class_ssl_destroy(rn_socket_t *socket)
 ssize_t rn_socket_class_ssl_read(rn_socket_t *socket, void *buf, size_t count)
 {
 	int ret;
+	int error;
 	rn_ssl_t *ssl = rn_ssl_get(socket);
 
 	if (rn_socket_waitio(socket) != 0) {
 		return -1;
 	}
 	/* Don't need to wait for input here as SSL is buffered */
-	while ((ret = SSL_read(ssl->ssl, buf, count)) < 0) {
-		switch(SSL_get_error(ssl->ssl, ret)) {
+	while ((ret = rn_socket_stat_in(socket, SSL_read(ssl->ssl, buf, count))) < 0) {
+		error = SSL_get_error(ssl->ssl, ret);
+		switch(error) {
 		case SSL_ERROR_NONE:
 			return 0;
 		case SSL_ERROR_ZERO_RETURN:
 		case SSL_ERROR_WANT_X509_LOOKUP:
 		case SSL_ERROR_SYSCALL:
 		case SSL_ERROR_SSL:
+			rn_socket_class_ssl_failed(ssl, error);
 			return -1;
 		case SSL_ERROR_WANT_READ:
 			if (rn_socket_waitin(&ssl->socket) != 0) {
@@ -126,6 +239,7 @@ ssize_t rn_socket_class_ssl_read(rn_socket_t *socket, void *buf, size_t count)
 		}
 	}
 	if (ret <= 0) {
+		rn_socket_class_ssl_failed(ssl, SSL_get_error(ssl->ssl, ret));
 		return -1;
 	}
 	return ret;
@@ -144,7 +258,9 @@ ssize_t rn_socket_class_ssl_read(rn_socket_t *socket, void *buf, size_t count)
 ssize_t	rn_socket_class_ssl_write(rn_socket_t *socket, const void *buf, size_t count)
 {
 	int ret;
+	int error;
 	size_t sent;
+	ssize_t len;
 	rn_ssl_t *ssl = rn_ssl_get(socket);
 
 	sent = count;
@@ -152,14 +268,20 @@ ssize_t	rn_socket_class_ssl_write(rn_socket_t *socket, const void *buf, size_t c
 		if (rn_socket_waitio(socket) != 0) {
 			return -1;
 		}
-		while ((ret = SSL_write(ssl->ssl, buf, count)) < 0) {
-			switch(SSL_get_error(ssl->ssl, ret)) {
+		len = rn_socket_throttle(socket, count);
+		if (len < 0) {
+			return -1;
+		}
+		while ((ret = rn_socket_throttled(socket, rn_socket_stat_out(socket, SSL_write(ssl->ssl, buf, len)))) < 0) {
+			error = SSL_get_error(ssl->ssl, ret);
+			switch(error) {
 			case SSL_ERROR_NONE:
 				return 0;
 			case SSL_ERROR_ZERO_RETURN:
 			case SSL_ERROR_WANT_X509_LOOKUP:
 			case SSL_ERROR_SYSCALL:
 			case SSL_ERROR_SSL:
+				rn_socket_class_ssl_failed(ssl, error);
 				return -1;
 			case SSL_ERROR_WANT_READ:
 				if (rn_socket_waitin(socket) != 0) {
@@ -176,6 +298,7 @@ ssize_t	rn_socket_class_ssl_write(rn_socket_t *socket, const void *buf, size_t c
 			}
 		}
 		if (ret <= 0) {
+			rn_socket_class_ssl_failed(ssl, SSL_get_error(ssl->ssl, ret));
 			return -1;
 		}
 		count -= ret;
@@ -184,6 +307,96 @@ ssize_t	rn_socket_class_ssl_write(rn_socket_t *socket, const void *buf, size_t c
 	return sent;
 }
 
+/**
+ * Replacement to the writev(2) syscall in this library.
+ * When the kernel encrypts records (kTLS), buffers are written directly to the socket.
+ * Otherwise, buffers are gathered in a per-connection record buffer so that small
+ * buffers (like response headers and body) share TLS records instead of getting one each.
+ *
+ * @param socket Pointer to the socket to write to
+ * @param buffers Array of buffers
+ * @param count Array size
+ *
+ * @return The number of bytes written on success or -1 if an error occurs
+ */
+ssize_t	rn_socket_class_ssl_writev(rn_socket_t *socket, rn_buffer_t **buffers, int count)
+{
+	int i;
+	char *ptr;
+	size_t len;
+	size_t size;
+	size_t fill;
+	ssize_t sent;
+	rn_ssl_t *ssl = rn_ssl_get(socket);
+
+	if (ssl->ktls) {
+		return rn_socket_class_tcp_writev(socket, buffers, count);
+	}
+	if (ssl->record == NULL) {
+		ssl->record = malloc(RN_SSL_RECORD_SIZE);
+		if (unlikely(ssl->record == NULL)) {
+			rn_error_set(errno);
+			return -1;
+		}
+	}
+	fill = 0;
+	for (i = 0, sent = 0; i < count; i++) {
+		ptr = rn_buffer_ptr(buffers[i]);
+		size = rn_buffer_size(buffers[i]);
+		sent += size;
+		while (size > 0) {
+			if (fill == 0 && size >= RN_SSL_RECORD_SIZE) {
+				/* Full records can be encrypted straight from the buffer */
+				len = size - size % RN_SSL_RECORD_SIZE;
+				if (rn_socket_class_ssl_write(socket, ptr, len) < 0) {
+					return -1;
+				}
+			} else {
+				len = RN_SSL_RECORD_SIZE - fill;
+				if (len > size) {
+					len = size;
+				}
+				memcpy(ssl->record + fill, ptr, len);
+				fill += len;
+				if (fill == RN_SSL_RECORD_SIZE) {
+					if (rn_socket_class_ssl_write(socket, ssl->record, fill) < 0) {
+						return -1;
+					}
+					fill = 0;
+				}
+			}
+			ptr += len;
+			size -= len;
+		}
+	}
+	if (fill > 0 && rn_socket_class_ssl_write(socket, ssl->record, fill) < 0) {
+		return -1;
+	}
+	return sent;
+}
+
+/**
+ * Replacement function for sendfile(2).
+ * File pages are sent without being copied to user space only when the kernel encrypts records (kTLS).
+ *
+ * @param socket Pointer to the socket to send the file to
+ * @param in_fd File descriptor of file to send
+ * @param offset File offset
+ * @param count Number of bytes to send
+ *
+ * @return Number of bytes correctly sent or -1 if an error occurs (EOPNOTSUPP when kTLS is not used)
+ */
+ssize_t rn_socket_class_ssl_sendfile(rn_socket_t *socket, int in_fd, off_t offset, size_t count)
+{
+	rn_ssl_t *ssl = rn_ssl_get(socket);
+
+	if (!ssl->ktls) {
+		rn_error_set(EOPNOTSUPP);
+		return -1;
+	}
+	return rn_socket_class_tcp_sendfile(socket, in_fd, offset, count);
+}
+
 /**
  * Replacement to the connect(2) syscall.
  *
@@ -195,7 +408,9 @@ ssize_t	rn_socket_class_ssl_write(rn_socket_t *socket, const void *buf, size_t c
 int rn_socket_class_ssl_connect(rn_socket_t *socket, const rn_addr_t *dst)
 {
 	int ret;
+	int error;
 	BIO *sbio;
+	SSL_SESSION *session;
 	rn_ssl_t *ssl = rn_ssl_get(socket);
 
 	if (unlikely(rn_socket_class_tcp_connect(socket, dst) != 0)) {
@@ -205,19 +420,27 @@ int rn_socket_class_ssl_connect(rn_socket_t *socket, const rn_addr_t *dst)
 	if (unlikely(ssl->ssl == NULL)) {
 		return -1;
 	}
+	session = rn_ssl_cache_client(ssl->ctx, dst);
+	if (session != NULL) {
+		/* Try to resume the last session established with this destination */
+		SSL_set_session(ssl->ssl, session);
+		SSL_SESSION_free(session);
+	}
 	sbio = BIO_new_socket(ssl->socket.node.fd, BIO_NOCLOSE);
 	if (unlikely(sbio == NULL)) {
 		return -1;
 	}
 	SSL_set_bio(ssl->ssl, sbio, sbio);
 	while ((ret = SSL_connect(ssl->ssl)) < 0) {
-		switch(SSL_get_error(ssl->ssl, ret)) {
+		error = SSL_get_error(ssl->ssl, ret);
+		switch(error) {
 		case SSL_ERROR_NONE:
 			return 0;
 		case SSL_ERROR_ZERO_RETURN:
 		case SSL_ERROR_WANT_X509_LOOKUP:
 		case SSL_ERROR_SYSCALL:
 		case SSL_ERROR_SSL:
+			rn_socket_class_ssl_failed(ssl, error);
 			return -1;
 		case SSL_ERROR_WANT_READ:
 			if (rn_socket_waitin(&ssl->socket) != 0) {
@@ -235,8 +458,10 @@ int rn_socket_class_ssl_connect(rn_socket_t *socket, const rn_addr_t *dst)
 		}
 	}
 	if (ret == 0) {
+		rn_socket_class_ssl_failed(ssl, SSL_get_error(ssl->ssl, ret));
 		return -1;
 	}
+	ssl->ktls = rn_socket_class_ssl_ktls(ssl);
 	return 0;
 }
 
@@ -253,6 +478,7 @@ rn_socket_t *rn_socket_class_ssl_accept(rn_socket_t *socket, rn_addr_t *from)
 {
 	int fd;
 	int ret;
+	int error;
 	BIO *sbio;
 	rn_ssl_t *new;
 	socklen_t addr_len;
@@ -303,13 +529,25 @@ rn_socket_t *rn_socket_class_ssl_accept(rn_socket_t *socket, rn_addr_t *from)
 		return NULL;
 	}
 	SSL_set_bio(new->ssl, sbio, sbio);
+	SSL_set_accept_state(new->ssl);
+	if (new->ctx->offload != NULL) {
+		/* Handshake crypto runs on workers, this task only waits for it */
+		if (rn_ssl_offload_handshake(new) != 0) {
+			rn_socket_destroy(&new->socket);
+			return NULL;
+		}
+		new->ktls = rn_socket_class_ssl_ktls(new);
+		return &new->socket;
+	}
 	while ((ret = SSL_accept(new->ssl)) <= 0) {
-		switch(SSL_get_error(new->ssl, ret)) {
+		error = SSL_get_error(new->ssl, ret);
+		switch(error) {
 		case SSL_ERROR_ZERO_RETURN:
 		case SSL_ERROR_WANT_X509_LOOKUP:
 		case SSL_ERROR_SYSCALL:
 		case SSL_ERROR_SSL:
 			//FIXME set rn_error
+			rn_socket_class_ssl_failed(new, error);
 			rn_socket_destroy(&new->socket);
 			return NULL;
 		case SSL_ERROR_WANT_READ:
@@ -329,5 +567,6 @@ rn_socket_t *rn_socket_class_ssl_accept(rn_socket_t *socket, rn_addr_t *from)
 
 		}
 	}
+	new->ktls = rn_socket_class_ssl_ktls(new);
 	return &new->socket;
 }
@@ -24,6 +24,8 @@ const rn_socket_class_t socket_class_tcp = {
 	.writev = rn_socket_class_tcp_writev,
 	.sendto = rn_socket_class_tcp_sendto,
 	.sendfile = rn_socket_class_tcp_sendfile,
+	.recvmmsg = NULL,
+	.sendmmsg = NULL,
 	.connect = rn_socket_class_tcp_connect,
 	.bind = rn_socket_class_tcp_bind,
 	.accept = rn_socket_class_tcp_accept
@@ -43,6 +45,8 @@ const rn_socket_class_t socket_class_tcp6 = {
 	.writev = rn_socket_class_tcp_writev,
 	.sendto = rn_socket_class_tcp_sendto,
 	.sendfile = rn_socket_class_tcp_sendfile,
+	.recvmmsg = NULL,
+	.sendmmsg = NULL,
 	.connect = rn_socket_class_tcp_connect,
 	.bind = rn_socket_class_tcp_bind,
 	.accept = rn_socket_class_tcp_accept
@@ -121,6 +125,16 @@ rn_socket_t *rn_socket_class_tcp_dup(rn_sched_t *destination, rn_socket_t *socke
 		return NULL;
 	}
 	*new = *socket;
+	/* The duplicate is not registered in any scheduler yet */
+	memset(&new->node, 0, sizeof(new->node));
+	new->zerocopy = NULL;
+	/* Rate limits are bound to the source scheduler */
+	new->ratelimit = NULL;
+	new->ratelimit_group = NULL;
+	new->flags &= ~RN_SOCKET_FLAG_RATELIMIT;
+	/* Cork is released by the source socket task */
+	new->flags &= ~RN_SOCKET_FLAG_CORKED;
+	new->cork_task = NULL;
 	new->node.fd = dup(socket->node.fd);
 	if (unlikely(new->node.fd < 0)) {
 		free(new);
@@ -161,7 +175,7 @@ ssize_t rn_socket_class_tcp_read(rn_socket_t *socket, void *buf, size_t count)
 	if (rn_socket_waitio(socket) != 0) {
 		return -1;
 	}
-	while ((ret = read(socket->node.fd, buf, count)) < 0) {
+	while ((ret = rn_socket_stat_in(socket, read(socket->node.fd, buf, count))) < 0) {
 		if (errno != EAGAIN && errno != EWOULDBLOCK) {
 			rn_error_set(errno);
 			return -1;
@@ -197,7 +211,7 @@ ssize_t rn_socket_class_tcp_recvfrom(rn_socket_t *socket, void *buf, size_t coun
 		return -1;
 	}
 	addr_len = sizeof(*from);
-	while ((ret = recvfrom(socket->node.fd, buf, count, MSG_DONTWAIT, &from->sa, &addr_len)) < 0) {
+	while ((ret = rn_socket_stat_in(socket, recvfrom(socket->node.fd, buf, count, MSG_DONTWAIT, &from->sa, &addr_len))) < 0) {
 		if (errno != EAGAIN && errno != EWOULDBLOCK) {
 			rn_error_set(errno);
 			return -1;
@@ -228,13 +242,18 @@ ssize_t	rn_socket_class_tcp_write(rn_socket_t *socket, const void *buf, size_t c
 {
 	size_t sent;
 	ssize_t ret;
+	ssize_t len;
 
 	sent = count;
 	while (count > 0) {
 		if (rn_socket_waitio(socket) != 0) {
 			return -1;
 		}
-		ret = write(socket->node.fd, buf, count);
+		len = rn_socket_throttle(socket, count);
+		if (len < 0) {
+			return -1;
+		}
+		ret = rn_socket_throttled(socket, rn_socket_stat_out(socket, write(socket->node.fd, buf, len)));
 		if (ret == 0) {
 			//FIXME: set rn_error
 			return -1;
@@ -267,9 +286,13 @@ ssize_t	rn_socket_class_tcp_write(rn_socket_t *socket, const void *buf, size_t c
 ssize_t	rn_socket_class_tcp_writev(rn_socket_t *socket, rn_buffer_t **buffers, int count)
 {
 	int i;
+	int last;
 	ssize_t ret;
+	ssize_t len;
 	ssize_t sent;
 	size_t total;
+	size_t clip;
+	size_t saved;
 	struct iovec *iov;
 
 	if (count > IOV_MAX) {
@@ -287,7 +310,18 @@ ssize_t	rn_socket_class_tcp_writev(rn_socket_t *socket, rn_buffer_t **buffers, i
 		if (rn_socket_waitio(socket) != 0) {
 			return -1;
 		}
-		ret = writev(socket->node.fd, iov, count);
+		len = rn_socket_throttle(socket, total - sent);
+		if (len < 0) {
+			return -1;
+		}
+		/* Only len bytes can be sent, the last vector is clipped */
+		for (last = 0, clip = 0; last < count - 1 && clip + iov[last].iov_len < (size_t) len; last++) {
+			clip += iov[last].iov_len;
+		}
+		saved = iov[last].iov_len;
+		iov[last].iov_len = len - clip;
+		ret = rn_socket_throttled(socket, rn_socket_stat_out(socket, writev(socket->node.fd, iov, last + 1)));
+		iov[last].iov_len = saved;
 		if (ret == 0) {
 			//FIXME: set rn_error
 			return -1;
@@ -349,13 +383,18 @@ ssize_t rn_socket_class_tcp_sendfile(rn_socket_t *socket, int in_fd, off_t offse
 {
 	size_t sent;
 	ssize_t ret;
+	ssize_t len;
 
 	if (rn_socket_waitio(socket) != 0) {
 		return -1;
 	}
 	sent = count;
 	while (count > 0) {
-		ret = sendfile(socket->node.fd, in_fd, &offset, count);
+		len = rn_socket_throttle(socket, count);
+		if (len < 0) {
+			return -1;
+		}
+		ret = rn_socket_throttled(socket, rn_socket_stat_out(socket, sendfile(socket->node.fd, in_fd, &offset, len)));
 		if (ret == 0) {
 			//FIXME: set rn_error
 			return -1;
@@ -449,6 +488,7 @@ int rn_socket_class_tcp_bind(rn_socket_t *socket, const rn_addr_t *dst, int back
 	if (setsockopt(socket->node.fd, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled)) == -1) {
 		return -1;
 	}
+
 	if (bind(socket->node.fd, &dst->sa, sizeof(*dst)) == -1) {
 		return -1;
 	}
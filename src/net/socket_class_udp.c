@@ -24,6 +24,8 @@ const rn_socket_class_t socket_class_udp = {
 	.writev = rn_socket_class_udp_writev,
 	.sendto = rn_socket_class_udp_sendto,
 	.sendfile = NULL,
+	.recvmmsg = rn_socket_class_udp_recvmmsg,
+	.sendmmsg = rn_socket_class_udp_sendmmsg,
 	.connect = rn_socket_class_udp_connect,
 	.bind = rn_socket_class_udp_bind,
 	.accept = NULL
@@ -43,6 +45,8 @@ const rn_socket_class_t socket_class_udp6 = {
 	.writev = rn_socket_class_udp_writev,
 	.sendto = rn_socket_class_udp_sendto,
 	.sendfile = NULL,
+	.recvmmsg = rn_socket_class_udp_recvmmsg,
+	.sendmmsg = rn_socket_class_udp_sendmmsg,
 	.connect = rn_socket_class_udp_connect,
 	.bind = rn_socket_class_udp_bind,
 	.accept = NULL
@@ -121,6 +125,13 @@ rn_socket_t *rn_socket_class_udp_dup(rn_sched_t *destination, rn_socket_t *socke
 		return NULL;
 	}
 	*new = *socket;
+	/* The duplicate is not registered in any scheduler yet */
+	memset(&new->node, 0, sizeof(new->node));
+	new->zerocopy = NULL;
+	/* Rate limits are bound to the source scheduler */
+	new->ratelimit = NULL;
+	new->ratelimit_group = NULL;
+	new->flags &= ~RN_SOCKET_FLAG_RATELIMIT;
 	new->node.fd = dup(socket->node.fd);
 	if (unlikely(new->node.fd < 0)) {
 		free(new);
@@ -161,7 +172,7 @@ ssize_t rn_socket_class_udp_read(rn_socket_t *socket, void *buf, size_t count)
 	if (rn_socket_waitio(socket) != 0) {
 		return -1;
 	}
-	while ((ret = read(socket->node.fd, buf, count)) < 0) {
+	while ((ret = rn_socket_stat_in(socket, read(socket->node.fd, buf, count))) < 0) {
 		if (errno != EAGAIN && errno != EWOULDBLOCK) {
 			rn_error_set(errno);
 			return -1;
@@ -197,7 +208,7 @@ ssize_t rn_socket_class_udp_recvfrom(rn_socket_t *socket, void *buf, size_t coun
 		return -1;
 	}
 	addr_len = sizeof(*from);
-	while ((ret = recvfrom(socket->node.fd, buf, count, MSG_DONTWAIT, &from->sa, &addr_len)) < 0) {
+	while ((ret = rn_socket_stat_in(socket, recvfrom(socket->node.fd, buf, count, MSG_DONTWAIT, &from->sa, &addr_len))) < 0) {
 		if (errno != EAGAIN && errno != EWOULDBLOCK) {
 			rn_error_set(errno);
 			return -1;
@@ -234,7 +245,10 @@ ssize_t	rn_socket_class_udp_write(rn_socket_t *socket, const void *buf, size_t c
 		if (rn_socket_waitio(socket) != 0) {
 			return -1;
 		}
-		ret = write(socket->node.fd, buf, count);
+		if (rn_socket_throttle(socket, count) < 0) {
+			return -1;
+		}
+		ret = rn_socket_throttled(socket, rn_socket_stat_out(socket, write(socket->node.fd, buf, count)));
 		if (ret == 0) {
 			//FIXME set rn_error
 			return -1;
@@ -287,7 +301,10 @@ ssize_t	rn_socket_class_udp_writev(rn_socket_t *socket, rn_buffer_t **buffers, i
 		if (rn_socket_waitio(socket) != 0) {
 			return -1;
 		}
-		ret = writev(socket->node.fd, iov, count);
+		if (rn_socket_throttle(socket, total - sent) < 0) {
+			return -1;
+		}
+		ret = rn_socket_throttled(socket, rn_socket_stat_out(socket, writev(socket->node.fd, iov, count)));
 		if (ret == 0) {
 			//FIXME set rn_error
 			return -1;
@@ -340,7 +357,10 @@ ssize_t rn_socket_class_udp_sendto(rn_socket_t *socket, void *buf, size_t count,
 		if (rn_socket_waitio(socket) != 0) {
 			return -1;
 		}
-		ret = sendto(socket->node.fd, buf, count, MSG_DONTWAIT, &dst->sa, sizeof(*dst));
+		if (rn_socket_throttle(socket, count) < 0) {
+			return -1;
+		}
+		ret = rn_socket_throttled(socket, rn_socket_stat_out(socket, sendto(socket->node.fd, buf, count, MSG_DONTWAIT, &dst->sa, rn_addr_len(dst))));
 		if (ret == 0) {
 			//FIXME set rn_error
 			return -1;
@@ -360,6 +380,155 @@ ssize_t rn_socket_class_udp_sendto(rn_socket_t *socket, void *buf, size_t count,
 	return sent;
 }
 
+/**
+ * Sums up the size of datagrams transferred by a recvmmsg or sendmmsg call.
+ *
+ * @param hdrs Array of message headers
+ * @param ret Syscall return value (number of messages, or -1)
+ *
+ * @return Number of bytes transferred, or -1 if ret is -1
+ */
+static ssize_t rn_socket_class_udp_mmsglen(struct mmsghdr *hdrs, int ret)
+{
+	int i;
+	ssize_t len;
+
+	if (ret < 0) {
+		return -1;
+	}
+	for (i = 0, len = 0; i < ret; i++) {
+		len += hdrs[i].msg_len;
+	}
+	return len;
+}
+
+/**
+ * Replacement to the recvmmsg(2) syscall in this library.
+ * This function receives up to count datagrams, RN_MMSG_MAX per syscall.
+ * It only waits for the socket to be available for read operations
+ * when no datagram is pending.
+ *
+ * @param socket Pointer to the socket to read
+ * @param msgs Array of messages to fill
+ * @param count Number of messages
+ *
+ * @return The number of messages received on success or -1 if an error occurs
+ */
+int rn_socket_class_udp_recvmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count)
+{
+	int i;
+	int ret;
+	int chunk;
+	int received;
+	struct iovec iov[RN_MMSG_MAX];
+	struct mmsghdr hdrs[RN_MMSG_MAX];
+
+	if (rn_socket_waitio(socket) != 0) {
+		return -1;
+	}
+	received = 0;
+	while (received < count) {
+		chunk = (count - received < RN_MMSG_MAX ? count - received : RN_MMSG_MAX);
+		memset(hdrs, 0, sizeof(*hdrs) * chunk);
+		for (i = 0; i < chunk; i++) {
+			iov[i].iov_base = msgs[received + i].buf;
+			iov[i].iov_len = msgs[received + i].size;
+			hdrs[i].msg_hdr.msg_name = &msgs[received + i].addr;
+			hdrs[i].msg_hdr.msg_namelen = sizeof(msgs[received + i].addr);
+			hdrs[i].msg_hdr.msg_iov = &iov[i];
+			hdrs[i].msg_hdr.msg_iovlen = 1;
+		}
+		ret = recvmmsg(socket->node.fd, hdrs, chunk, MSG_DONTWAIT, NULL);
+		if (rn_stats_enabled(socket->node.sched)) {
+			rn_socket_stats_io(socket, RN_MODE_IN, rn_socket_class_udp_mmsglen(hdrs, ret));
+		}
+		if (ret < 0) {
+			if (received > 0) {
+				break;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				rn_error_set(errno);
+				return -1;
+			}
+			if (rn_socket_waitin(socket) != 0) {
+				return -1;
+			}
+			continue;
+		}
+		for (i = 0; i < ret; i++) {
+			msgs[received + i].len = hdrs[i].msg_len;
+		}
+		received += ret;
+		if (ret < chunk) {
+			break;
+		}
+	}
+	return received;
+}
+
+/**
+ * Replacement to the sendmmsg(2) syscall in this library.
+ * This function sends count datagrams, RN_MMSG_MAX per syscall, and
+ * waits for the socket to be available for write operations when needed.
+ * Messages with an AF_UNSPEC address are sent to the connected peer.
+ *
+ * @param socket Pointer to the socket to write to
+ * @param msgs Array of messages to send
+ * @param count Number of messages
+ *
+ * @return The number of messages sent on success or -1 if an error occurs
+ */
+int rn_socket_class_udp_sendmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count)
+{
+	int i;
+	int ret;
+	int sent;
+	int chunk;
+	size_t len;
+	struct iovec iov[RN_MMSG_MAX];
+	struct mmsghdr hdrs[RN_MMSG_MAX];
+
+	if (rn_socket_waitio(socket) != 0) {
+		return -1;
+	}
+	sent = 0;
+	while (sent < count) {
+		chunk = (count - sent < RN_MMSG_MAX ? count - sent : RN_MMSG_MAX);
+		memset(hdrs, 0, sizeof(*hdrs) * chunk);
+		for (i = 0, len = 0; i < chunk; i++) {
+			iov[i].iov_base = msgs[sent + i].buf;
+			iov[i].iov_len = msgs[sent + i].len;
+			len += msgs[sent + i].len;
+			if (msgs[sent + i].addr.sa.sa_family != AF_UNSPEC) {
+				hdrs[i].msg_hdr.msg_name = &msgs[sent + i].addr;
+				hdrs[i].msg_hdr.msg_namelen = rn_addr_len(&msgs[sent + i].addr);
+			}
+			hdrs[i].msg_hdr.msg_iov = &iov[i];
+			hdrs[i].msg_hdr.msg_iovlen = 1;
+		}
+		if (rn_socket_throttle(socket, len) < 0) {
+			return (sent > 0 ? sent : -1);
+		}
+		ret = sendmmsg(socket->node.fd, hdrs, chunk, MSG_DONTWAIT);
+		if (rn_stats_enabled(socket->node.sched)) {
+			rn_socket_stats_io(socket, RN_MODE_OUT, rn_socket_class_udp_mmsglen(hdrs, ret));
+		}
+		rn_socket_throttled(socket, rn_socket_class_udp_mmsglen(hdrs, ret));
+		if (ret < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				rn_error_set(errno);
+				return (sent > 0 ? sent : -1);
+			}
+			if (rn_socket_waitout(socket) != 0) {
+				return (sent > 0 ? sent : -1);
+			}
+			continue;
+		}
+		sent += ret;
+	}
+	return sent;
+}
+
 /**
  * Replacement to the connect(2) syscall.
  *
@@ -381,7 +550,7 @@ int rn_socket_class_udp_connect(rn_socket_t *socket, const rn_addr_t *dst)
 		rn_error_set(errno);
 		return -1;
 	}
-	if (connect(socket->node.fd, &dst->sa, sizeof(*dst)) == 0) {
+	if (connect(socket->node.fd, &dst->sa, rn_addr_len(dst)) == 0) {
 		return 0;
 	}
 	switch (errno) {
@@ -0,0 +1,177 @@
+/**
+ * @file   socket_class_unix.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Unix domain socket classes
+ *
+ *
+ */
+
+#include "rinoo/net/module.h"
+
+const rn_socket_class_t socket_class_unix = {
+	.domain = AF_UNIX,
+	.type = SOCK_STREAM,
+	.create = rn_socket_class_tcp_create,
+	.destroy = rn_socket_class_tcp_destroy,
+	.open = rn_socket_class_tcp_open,
+	.dup = rn_socket_class_tcp_dup,
+	.close = rn_socket_class_tcp_close,
+	.read = rn_socket_class_tcp_read,
+	.recvfrom = rn_socket_class_tcp_recvfrom,
+	.write = rn_socket_class_tcp_write,
+	.writev = rn_socket_class_tcp_writev,
+	.sendto = rn_socket_class_tcp_sendto,
+	.sendfile = rn_socket_class_tcp_sendfile,
+	.recvmmsg = NULL,
+	.sendmmsg = NULL,
+	.connect = rn_socket_class_unix_connect,
+	.bind = rn_socket_class_unix_bind,
+	.accept = rn_socket_class_tcp_accept
+};
+
+const rn_socket_class_t socket_class_unixdgram = {
+	.domain = AF_UNIX,
+	.type = SOCK_DGRAM,
+	.create = rn_socket_class_udp_create,
+	.destroy = rn_socket_class_udp_destroy,
+	.open = rn_socket_class_udp_open,
+	.dup = rn_socket_class_udp_dup,
+	.close = rn_socket_class_udp_close,
+	.read = rn_socket_class_udp_read,
+	.recvfrom = rn_socket_class_unix_recvfrom,
+	.write = rn_socket_class_udp_write,
+	.writev = rn_socket_class_udp_writev,
+	.sendto = rn_socket_class_udp_sendto,
+	.sendfile = NULL,
+	.recvmmsg = rn_socket_class_unix_recvmmsg,
+	.sendmmsg = rn_socket_class_udp_sendmmsg,
+	.connect = rn_socket_class_unix_connect,
+	.bind = rn_socket_class_unix_bind,
+	.accept = NULL
+};
+
+/**
+ * Replacement to the recvfrom(2) syscall for unix datagram sockets.
+ * The source address is zeroed first: the kernel only fills the bytes
+ * of the sender name, which must be null-terminated to be reused.
+ *
+ * @param socket Pointer to the socket to read
+ * @param buf Buffer where to store the information read
+ * @param count Buffer size
+ * @param from Originating address
+ *
+ * @return The number of bytes read on success or -1 if an error occurs
+ */
+ssize_t rn_socket_class_unix_recvfrom(rn_socket_t *socket, void *buf, size_t count, rn_addr_t *from)
+{
+	memset(from, 0, sizeof(*from));
+	return rn_socket_class_udp_recvfrom(socket, buf, count, from);
+}
+
+/**
+ * Replacement to the recvmmsg(2) syscall for unix datagram sockets.
+ * Source addresses are zeroed first, like in rn_socket_class_unix_recvfrom.
+ *
+ * @param socket Pointer to the socket to read
+ * @param msgs Array of messages to fill
+ * @param count Number of messages
+ *
+ * @return The number of messages received on success or -1 if an error occurs
+ */
+int rn_socket_class_unix_recvmmsg(rn_socket_t *socket, rn_msg_t *msgs, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		memset(&msgs[i].addr, 0, sizeof(msgs[i].addr));
+	}
+	return rn_socket_class_udp_recvmmsg(socket, msgs, count);
+}
+
+/**
+ * Replacement to the connect(2) syscall for unix sockets.
+ * Local connections complete at once. When the listening queue of the
+ * server is full, the kernel returns EAGAIN instead of waiting, the
+ * connection is then retried every millisecond.
+ *
+ * @param socket Pointer to the socket to connect
+ * @param dst Destination address
+ *
+ * @return 0 on success or -1 if an error occurs (ETIMEDOUT on socket timeout)
+ */
+int rn_socket_class_unix_connect(rn_socket_t *socket, const rn_addr_t *dst)
+{
+	XASSERT(socket != NULL, -1);
+	XASSERT(dst != NULL, -1);
+
+	while (connect(socket->node.fd, &dst->sa, rn_addr_len(dst)) != 0) {
+		if (errno != EAGAIN) {
+			rn_error_set(errno);
+			return -1;
+		}
+		/* Keeps a timeout set with rn_socket_timeout running */
+		if (rn_task_delay_us(socket->node.sched, 1000) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Checks whether a socket file is left over by a process which is gone,
+ * that is whether connecting to it is refused.
+ *
+ * @param dst Address of the socket file
+ * @param type Socket type (SOCK_STREAM or SOCK_DGRAM)
+ *
+ * @return true if the socket file can be removed, otherwise false
+ */
+static bool rn_socket_class_unix_stale(const rn_addr_t *dst, int type)
+{
+	int fd;
+	bool stale;
+
+	fd = socket(AF_UNIX, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return false;
+	}
+	stale = (connect(fd, &dst->sa, rn_addr_len(dst)) != 0 && errno == ECONNREFUSED);
+	close(fd);
+	return stale;
+}
+
+/**
+ * Binds a unix socket to the specified address, and marks stream sockets
+ * as listening to new connections.
+ * A socket file left over at a file system path is removed first, unless
+ * a server still listens on it: binding then fails with EADDRINUSE.
+ *
+ * @param socket Pointer to the socket to bind
+ * @param dst Address to bind
+ * @param backlog Maximum listening queue size (see man listen), ignored for datagram sockets
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_socket_class_unix_bind(rn_socket_t *socket, const rn_addr_t *dst, int backlog)
+{
+	struct stat st;
+
+	XASSERT(socket != NULL, -1);
+	XASSERT(dst != NULL, -1);
+
+	if (dst->un.sun_path[0] != '\0' && stat(dst->un.sun_path, &st) == 0 && S_ISSOCK(st.st_mode) &&
+	    rn_socket_class_unix_stale(dst, socket->class->type)) {
+		unlink(dst->un.sun_path);
+	}
+	if (bind(socket->node.fd, &dst->sa, rn_addr_len(dst)) == -1) {
+		rn_error_set(errno);
+		return -1;
+	}
+	if (socket->class->type == SOCK_STREAM && listen(socket->node.fd, backlog) == -1) {
+		rn_error_set(errno);
+		return -1;
+	}
+	return 0;
+}
@@ -39,7 +39,7 @@ rn_ssl_ctx_t *rn_ssl_context(void)
 		EVP_PKEY_free(pkey);
 		return NULL;
 	}
-	rsa = RSA_generate_key(512, RSA_F4, NULL,NULL);
+	rsa = RSA_generate_key(2048, RSA_F4, NULL,NULL);
 	if (rsa == NULL || EVP_PKEY_assign_RSA(pkey, rsa) == 0) {
 		X509_free(x509);
 		EVP_PKEY_free(pkey);
@@ -63,12 +63,12 @@ rn_ssl_ctx_t *rn_ssl_context(void)
 		return NULL;
 	}
 	X509_set_issuer_name(x509, name);
-	if (X509_sign(x509, pkey, EVP_md5()) == 0) {
+	if (X509_sign(x509, pkey, EVP_sha256()) == 0) {
 		X509_free(x509);
 		EVP_PKEY_free(pkey);
 		return NULL;
 	}
-	ssl = malloc(sizeof(*ssl));
+	ssl = calloc(1, sizeof(*ssl));
 	if (ssl == NULL) {
 		X509_free(x509);
 		EVP_PKEY_free(pkey);
@@ -84,6 +84,10 @@ rn_ssl_ctx_t *rn_ssl_context(void)
 	ssl->x509 = x509;
 	ssl->pkey = pkey;
 	ssl->ctx = ctx;
+#ifdef SSL_OP_ENABLE_KTLS
+	/* OpenSSL silently keeps user-space encryption if the kernel lacks the tls ULP */
+	SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif /* !SSL_OP_ENABLE_KTLS */
 	if (SSL_CTX_use_certificate(ctx, x509) == 0) {
 		rn_ssl_context_destroy(ssl);
 		return NULL;
@@ -92,6 +96,10 @@ rn_ssl_ctx_t *rn_ssl_context(void)
 		rn_ssl_context_destroy(ssl);
 		return NULL;
 	}
+	if (rn_ssl_cache(ssl) != 0) {
+		rn_ssl_context_destroy(ssl);
+		return NULL;
+	}
 	return ssl;
 }
 
@@ -103,9 +111,11 @@ rn_ssl_ctx_t *rn_ssl_context(void)
 void rn_ssl_context_destroy(rn_ssl_ctx_t *ctx)
 {
 	if (ctx != NULL) {
+		rn_ssl_offload_destroy(ctx);
 		X509_free(ctx->x509);
 		EVP_PKEY_free(ctx->pkey);
 		SSL_CTX_free(ctx->ctx);
+		rn_ssl_cache_destroy(ctx);
 		free(ctx);
 	}
 }
@@ -122,6 +132,33 @@ rn_ssl_t *rn_ssl_get(rn_socket_t *socket)
 	return container_of(socket, rn_ssl_t, socket);
 }
 
+/**
+ * Checks whether the kernel encrypts data sent on a SSL socket (kTLS).
+ * In this case, writev and sendfile go straight to the kernel.
+ *
+ * @param socket Socket pointer
+ *
+ * @return true if kTLS is used for sending, false otherwise
+ */
+bool rn_ssl_ktls(rn_socket_t *socket)
+{
+	return rn_ssl_get(socket)->ktls;
+}
+
+/**
+ * Checks whether a SSL socket resumed a previous session (abbreviated handshake).
+ *
+ * @param socket Socket pointer
+ *
+ * @return true if the session was resumed, false otherwise
+ */
+bool rn_ssl_reused(rn_socket_t *socket)
+{
+	rn_ssl_t *ssl = rn_ssl_get(socket);
+
+	return (ssl->ssl != NULL && SSL_session_reused(ssl->ssl) == 1);
+}
+
 /**
  * Creates a SSL client and tries to connect to the specified address.
  *
@@ -0,0 +1,532 @@
+/**
+ * @file   ssl_cache.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  TLS session cache and ticket management
+ *
+ *
+ */
+
+#include "rinoo/net/module.h"
+
+/**
+ * Gets the cache of the context a SSL connection belongs to.
+ *
+ * @param ssl OpenSSL connection
+ *
+ * @return Pointer to the cache
+ */
+static rn_ssl_cache_t *rn_ssl_cache_get(SSL *ssl)
+{
+	rn_ssl_ctx_t *ctx;
+
+	ctx = SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+	return ctx->cache;
+}
+
+/**
+ * Gets the cache shard of the calling scheduler.
+ * Sessions are stored in the shard of the scheduler which created them,
+ * so that schedulers do not contend on the same lock.
+ *
+ * @return Shard index
+ */
+static int rn_ssl_cache_shard(void)
+{
+	rn_sched_t *sched;
+
+	sched = rn_scheduler_self();
+	if (sched == NULL) {
+		return 0;
+	}
+	return sched->id % RN_SSL_CACHE_SHARDS;
+}
+
+/**
+ * Gets the cache slot of a session id.
+ *
+ * @param id Session id
+ * @param len Session id length
+ *
+ * @return Slot index
+ */
+static uint32_t rn_ssl_cache_slot(const unsigned char *id, unsigned int len)
+{
+	uint32_t hash;
+
+	murmurhash3_x86_32(id, len, 0, &hash);
+	return hash % RN_SSL_CACHE_SLOTS;
+}
+
+/**
+ * Gets the client cache slot of a destination address.
+ *
+ * @param addr Destination address
+ *
+ * @return Slot index
+ */
+static uint32_t rn_ssl_cache_client_slot(const rn_addr_t *addr)
+{
+	uint32_t hash;
+
+	if (IS_IPV6(addr)) {
+		murmurhash3_x86_32(&addr->v6.sin6_addr, sizeof(addr->v6.sin6_addr), addr->v6.sin6_port, &hash);
+	} else {
+		murmurhash3_x86_32(&addr->v4.sin_addr, sizeof(addr->v4.sin_addr), addr->v4.sin_port, &hash);
+	}
+	return hash % RN_SSL_CLIENT_SLOTS;
+}
+
+/**
+ * Compares two destination addresses.
+ *
+ * @param addr1 First address
+ * @param addr2 Second address
+ *
+ * @return true if both addresses are the same, false otherwise
+ */
+static bool rn_ssl_cache_client_match(const rn_addr_t *addr1, const rn_addr_t *addr2)
+{
+	if (addr1->sa.sa_family != addr2->sa.sa_family) {
+		return false;
+	}
+	if (IS_IPV6(addr1)) {
+		return (addr1->v6.sin6_port == addr2->v6.sin6_port &&
+			memcmp(&addr1->v6.sin6_addr, &addr2->v6.sin6_addr, sizeof(addr1->v6.sin6_addr)) == 0);
+	}
+	return (addr1->v4.sin_port == addr2->v4.sin_port && addr1->v4.sin_addr.s_addr == addr2->v4.sin_addr.s_addr);
+}
+
+/**
+ * OpenSSL callback called when a new server session is established.
+ *
+ * @param ssl OpenSSL connection
+ * @param session New session
+ *
+ * @return 1 if the cache keeps the session reference, 0 otherwise
+ */
+static int rn_ssl_cache_new(SSL *ssl, SSL_SESSION *session)
+{
+	int shard;
+	uint32_t slot;
+	unsigned int len;
+	const unsigned char *id;
+	rn_ssl_cache_t *cache;
+
+	cache = rn_ssl_cache_get(ssl);
+	id = SSL_SESSION_get_id(session, &len);
+	slot = rn_ssl_cache_slot(id, len);
+	shard = rn_ssl_cache_shard();
+	pthread_mutex_lock(&cache->shards[shard].lock);
+	if (cache->shards[shard].sessions[slot] != NULL) {
+		SSL_SESSION_free(cache->shards[shard].sessions[slot]);
+	}
+	cache->shards[shard].sessions[slot] = session;
+	pthread_mutex_unlock(&cache->shards[shard].lock);
+	return 1;
+}
+
+/**
+ * OpenSSL callback looking up a session resumed by a client.
+ * The shard of the calling scheduler is searched first, then the other ones,
+ * as clients may reconnect to any scheduler.
+ *
+ * @param ssl OpenSSL connection
+ * @param id Session id
+ * @param len Session id length
+ * @param copy Set to 0 as the returned session is already referenced
+ *
+ * @return The session or NULL if not found
+ */
+static SSL_SESSION *rn_ssl_cache_lookup(SSL *ssl, const unsigned char *id, int len, int *copy)
+{
+	int i;
+	int shard;
+	uint32_t slot;
+	unsigned int curlen;
+	const unsigned char *curid;
+	SSL_SESSION *session;
+	rn_ssl_cache_t *cache;
+
+	*copy = 0;
+	cache = rn_ssl_cache_get(ssl);
+	slot = rn_ssl_cache_slot(id, len);
+	shard = rn_ssl_cache_shard();
+	for (i = 0; i < RN_SSL_CACHE_SHARDS; i++, shard = (shard + 1) % RN_SSL_CACHE_SHARDS) {
+		pthread_mutex_lock(&cache->shards[shard].lock);
+		session = cache->shards[shard].sessions[slot];
+		if (session != NULL) {
+			curid = SSL_SESSION_get_id(session, &curlen);
+			if (curlen == (unsigned int) len && memcmp(curid, id, len) == 0) {
+				SSL_SESSION_up_ref(session);
+				pthread_mutex_unlock(&cache->shards[shard].lock);
+				return session;
+			}
+		}
+		pthread_mutex_unlock(&cache->shards[shard].lock);
+	}
+	return NULL;
+}
+
+/**
+ * OpenSSL callback called when a session has to be removed (expired or invalid).
+ *
+ * @param sslctx OpenSSL context
+ * @param session Session to remove
+ */
+static void rn_ssl_cache_remove(SSL_CTX *sslctx, SSL_SESSION *session)
+{
+	int i;
+	uint32_t slot;
+	unsigned int len;
+	rn_ssl_ctx_t *ctx;
+	const unsigned char *id;
+	rn_ssl_cache_t *cache;
+
+	ctx = SSL_CTX_get_app_data(sslctx);
+	cache = ctx->cache;
+	id = SSL_SESSION_get_id(session, &len);
+	slot = rn_ssl_cache_slot(id, len);
+	for (i = 0; i < RN_SSL_CACHE_SHARDS; i++) {
+		pthread_mutex_lock(&cache->shards[i].lock);
+		if (cache->shards[i].sessions[slot] == session) {
+			cache->shards[i].sessions[slot] = NULL;
+			SSL_SESSION_free(session);
+		}
+		pthread_mutex_unlock(&cache->shards[i].lock);
+	}
+}
+
+/**
+ * Generates a new ticket key. The previous ones are shifted and
+ * stay valid to decrypt tickets until they drop out of the key array.
+ * Ticket lock must be held.
+ *
+ * @param cache Pointer to the cache
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+static int rn_ssl_cache_newkey(rn_ssl_cache_t *cache)
+{
+	rn_ssl_ticket_key_t key;
+
+	if (RAND_bytes(key.name, sizeof(key.name)) <= 0 ||
+	    RAND_bytes(key.aes, sizeof(key.aes)) <= 0 ||
+	    RAND_bytes(key.hmac, sizeof(key.hmac)) <= 0) {
+		return -1;
+	}
+	key.created = time(NULL);
+	memmove(&cache->tickets[1], &cache->tickets[0], sizeof(cache->tickets[0]) * (RN_SSL_TICKET_KEYS - 1));
+	cache->tickets[0] = key;
+	return 0;
+}
+
+/**
+ * Selects the ticket key to encrypt or decrypt a session ticket.
+ * The current key gets rotated once it reaches its lifetime.
+ *
+ * @param cache Pointer to the cache
+ * @param name Key name, filled when encrypting, looked up when decrypting
+ * @param key Pointer where to copy the key
+ * @param enc 1 to encrypt a new ticket, 0 to decrypt one
+ *
+ * @return 1 if the key is current, 2 if the ticket should be renewed, 0 if no key matches, -1 on error
+ */
+static int rn_ssl_cache_ticket_key(rn_ssl_cache_t *cache, unsigned char *name, rn_ssl_ticket_key_t *key, int enc)
+{
+	int i;
+	int ret;
+
+	ret = 0;
+	pthread_mutex_lock(&cache->ticket_lock);
+	if (time(NULL) - cache->tickets[0].created >= cache->ticket_lifetime && rn_ssl_cache_newkey(cache) != 0) {
+		pthread_mutex_unlock(&cache->ticket_lock);
+		return -1;
+	}
+	if (enc) {
+		*key = cache->tickets[0];
+		memcpy(name, key->name, sizeof(key->name));
+		ret = 1;
+	} else {
+		for (i = 0; i < RN_SSL_TICKET_KEYS; i++) {
+			if (cache->tickets[i].created != 0 && memcmp(name, cache->tickets[i].name, sizeof(cache->tickets[i].name)) == 0) {
+				*key = cache->tickets[i];
+				ret = (i == 0 ? 1 : 2);
+				break;
+			}
+		}
+	}
+	pthread_mutex_unlock(&cache->ticket_lock);
+	return ret;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+/**
+ * OpenSSL callback encrypting or decrypting session tickets.
+ *
+ * @param ssl OpenSSL connection
+ * @param name Key name
+ * @param iv Initialization vector
+ * @param cctx Cipher context to initialize
+ * @param hctx MAC context to initialize
+ * @param enc 1 to encrypt a new ticket, 0 to decrypt one
+ *
+ * @return 1 on success, 2 if the ticket should be renewed, 0 to ignore the ticket, -1 on error
+ */
+static int rn_ssl_cache_ticket(SSL *ssl, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *cctx, EVP_MAC_CTX *hctx, int enc)
+{
+	int ret;
+	OSSL_PARAM params[3];
+	rn_ssl_ticket_key_t key;
+
+	ret = rn_ssl_cache_ticket_key(rn_ssl_cache_get(ssl), name, &key, enc);
+	if (ret <= 0) {
+		return ret;
+	}
+	params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmac, sizeof(key.hmac));
+	params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "SHA256", 0);
+	params[2] = OSSL_PARAM_construct_end();
+	if (enc) {
+		if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) <= 0 ||
+		    EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aes, iv) == 0) {
+			return -1;
+		}
+	} else if (EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aes, iv) == 0) {
+		return -1;
+	}
+	if (EVP_MAC_CTX_set_params(hctx, params) == 0) {
+		return -1;
+	}
+	return ret;
+}
+#else
+/**
+ * OpenSSL callback encrypting or decrypting session tickets.
+ *
+ * @param ssl OpenSSL connection
+ * @param name Key name
+ * @param iv Initialization vector
+ * @param cctx Cipher context to initialize
+ * @param hctx HMAC context to initialize
+ * @param enc 1 to encrypt a new ticket, 0 to decrypt one
+ *
+ * @return 1 on success, 2 if the ticket should be renewed, 0 to ignore the ticket, -1 on error
+ */
+static int rn_ssl_cache_ticket(SSL *ssl, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *cctx, HMAC_CTX *hctx, int enc)
+{
+	int ret;
+	rn_ssl_ticket_key_t key;
+
+	ret = rn_ssl_cache_ticket_key(rn_ssl_cache_get(ssl), name, &key, enc);
+	if (ret <= 0) {
+		return ret;
+	}
+	if (enc) {
+		if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) <= 0 ||
+		    EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aes, iv) == 0) {
+			return -1;
+		}
+	} else if (EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aes, iv) == 0) {
+		return -1;
+	}
+	if (HMAC_Init_ex(hctx, key.hmac, sizeof(key.hmac), EVP_sha256(), NULL) == 0) {
+		return -1;
+	}
+	return ret;
+}
+#endif /* !OPENSSL_VERSION_NUMBER */
+
+/**
+ * Sets up session resumption for a SSL context.
+ * Server sessions are kept in a cache sharded by scheduler, session tickets
+ * are encrypted with keys rotated every RN_SSL_TICKET_LIFETIME seconds,
+ * and client sessions are kept per destination address for rn_ssl_client.
+ *
+ * @param ctx Pointer to the SSL context
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_ssl_cache(rn_ssl_ctx_t *ctx)
+{
+	int i;
+	rn_ssl_cache_t *cache;
+
+	XASSERT(ctx != NULL, -1);
+
+	cache = calloc(1, sizeof(*cache));
+	if (unlikely(cache == NULL)) {
+		rn_error_set(errno);
+		return -1;
+	}
+	for (i = 0; i < RN_SSL_CACHE_SHARDS; i++) {
+		pthread_mutex_init(&cache->shards[i].lock, NULL);
+	}
+	pthread_mutex_init(&cache->client_lock, NULL);
+	pthread_mutex_init(&cache->ticket_lock, NULL);
+	cache->ticket_lifetime = RN_SSL_TICKET_LIFETIME;
+	ctx->cache = cache;
+	if (rn_ssl_cache_newkey(cache) != 0) {
+		rn_ssl_cache_destroy(ctx);
+		return -1;
+	}
+	SSL_CTX_set_app_data(ctx->ctx, ctx);
+	SSL_CTX_set_session_id_context(ctx->ctx, (const unsigned char *) "RiNOO", 5);
+	SSL_CTX_set_session_cache_mode(ctx->ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+	SSL_CTX_sess_set_new_cb(ctx->ctx, rn_ssl_cache_new);
+	SSL_CTX_sess_set_get_cb(ctx->ctx, rn_ssl_cache_lookup);
+	SSL_CTX_sess_set_remove_cb(ctx->ctx, rn_ssl_cache_remove);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx->ctx, rn_ssl_cache_ticket);
+#else
+	SSL_CTX_set_tlsext_ticket_key_cb(ctx->ctx, rn_ssl_cache_ticket);
+#endif /* !OPENSSL_VERSION_NUMBER */
+	return 0;
+}
+
+/**
+ * Destroys the session cache of a SSL context.
+ *
+ * @param ctx Pointer to the SSL context
+ */
+void rn_ssl_cache_destroy(rn_ssl_ctx_t *ctx)
+{
+	int i;
+	int j;
+	rn_ssl_cache_t *cache;
+
+	XASSERTN(ctx != NULL);
+
+	cache = ctx->cache;
+	if (cache == NULL) {
+		return;
+	}
+	for (i = 0; i < RN_SSL_CACHE_SHARDS; i++) {
+		for (j = 0; j < RN_SSL_CACHE_SLOTS; j++) {
+			if (cache->shards[i].sessions[j] != NULL) {
+				SSL_SESSION_free(cache->shards[i].sessions[j]);
+			}
+		}
+		pthread_mutex_destroy(&cache->shards[i].lock);
+	}
+	for (i = 0; i < RN_SSL_CLIENT_SLOTS; i++) {
+		if (cache->clients[i].session != NULL) {
+			SSL_SESSION_free(cache->clients[i].session);
+		}
+	}
+	pthread_mutex_destroy(&cache->client_lock);
+	pthread_mutex_destroy(&cache->ticket_lock);
+	free(cache);
+	ctx->cache = NULL;
+}
+
+/**
+ * Stores the session of a client connection, keyed by the address of the connected peer.
+ * This is called when the connection is closed so that the last session ticket received is kept.
+ * OpenSSL client cache is not used as, with TLSv1.3, it invalidates a session once resumed,
+ * and tickets received afterwards inherit this state.
+ *
+ * @param ctx Pointer to the SSL context
+ * @param ssl OpenSSL client connection
+ */
+void rn_ssl_cache_client_store(rn_ssl_ctx_t *ctx, SSL *ssl)
+{
+	rn_addr_t addr;
+	socklen_t len;
+	SSL_SESSION *session;
+	rn_ssl_client_session_t *entry;
+
+	XASSERTN(ctx != NULL);
+	XASSERTN(ssl != NULL);
+
+	if (ctx->cache == NULL) {
+		return;
+	}
+	len = sizeof(addr);
+	if (getpeername(SSL_get_fd(ssl), &addr.sa, &len) != 0) {
+		return;
+	}
+	session = SSL_get1_session(ssl);
+	if (session == NULL) {
+		return;
+	}
+	if (!SSL_SESSION_is_resumable(session)) {
+		SSL_SESSION_free(session);
+		return;
+	}
+	entry = &ctx->cache->clients[rn_ssl_cache_client_slot(&addr)];
+	pthread_mutex_lock(&ctx->cache->client_lock);
+	if (entry->session != NULL) {
+		SSL_SESSION_free(entry->session);
+	}
+	entry->addr = addr;
+	entry->session = session;
+	pthread_mutex_unlock(&ctx->cache->client_lock);
+}
+
+/**
+ * Gets the last session established with a destination address.
+ *
+ * @param ctx Pointer to the SSL context
+ * @param dst Destination address
+ *
+ * @return A referenced session (to be freed with SSL_SESSION_free) or NULL if none is cached
+ */
+SSL_SESSION *rn_ssl_cache_client(rn_ssl_ctx_t *ctx, const rn_addr_t *dst)
+{
+	SSL_SESSION *session;
+	rn_ssl_client_session_t *entry;
+
+	XASSERT(ctx != NULL, NULL);
+	XASSERT(dst != NULL, NULL);
+
+	if (ctx->cache == NULL) {
+		return NULL;
+	}
+	session = NULL;
+	entry = &ctx->cache->clients[rn_ssl_cache_client_slot(dst)];
+	pthread_mutex_lock(&ctx->cache->client_lock);
+	if (entry->session != NULL && rn_ssl_cache_client_match(&entry->addr, dst)) {
+		session = entry->session;
+		SSL_SESSION_up_ref(session);
+	}
+	pthread_mutex_unlock(&ctx->cache->client_lock);
+	return session;
+}
+
+/**
+ * Rotates session ticket keys now. Tickets encrypted with the previous key
+ * are still accepted, and renewed with the new key.
+ *
+ * @param ctx Pointer to the SSL context
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_ssl_ticket_rotate(rn_ssl_ctx_t *ctx)
+{
+	int ret;
+
+	XASSERT(ctx != NULL, -1);
+	XASSERT(ctx->cache != NULL, -1);
+
+	pthread_mutex_lock(&ctx->cache->ticket_lock);
+	ret = rn_ssl_cache_newkey(ctx->cache);
+	pthread_mutex_unlock(&ctx->cache->ticket_lock);
+	return ret;
+}
+
+/**
+ * Sets how long a session ticket key is used before being rotated.
+ *
+ * @param ctx Pointer to the SSL context
+ * @param seconds Key lifetime in seconds
+ */
+void rn_ssl_ticket_lifetime(rn_ssl_ctx_t *ctx, uint32_t seconds)
+{
+	XASSERTN(ctx != NULL);
+	XASSERTN(ctx->cache != NULL);
+
+	pthread_mutex_lock(&ctx->cache->ticket_lock);
+	ctx->cache->ticket_lifetime = seconds;
+	pthread_mutex_unlock(&ctx->cache->ticket_lock);
+}
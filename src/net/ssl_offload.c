@@ -0,0 +1,219 @@
+/**
+ * @file   ssl_offload.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  TLS handshake offload to a crypto worker pool
+ *
+ *
+ */
+
+#include "rinoo/net/module.h"
+
+/**
+ * Crypto worker loop.
+ * Each job runs one step of a handshake (until OpenSSL needs more data
+ * from the network) and notifies the task waiting for it.
+ *
+ * @param arg Pointer to the offload pool
+ *
+ * @return NULL
+ */
+static void *rn_ssl_offload_loop(void *arg)
+{
+	uint64_t value;
+	rn_ssl_job_t *job;
+	rn_list_node_t *node;
+	rn_ssl_offload_t *offload = arg;
+
+	pthread_mutex_lock(&offload->lock);
+	while (!offload->stop) {
+		node = offload->jobs.tail;
+		if (node == NULL) {
+			pthread_cond_wait(&offload->cond, &offload->lock);
+			continue;
+		}
+		/* Jobs are put at the head of the list, oldest first */
+		rn_list_remove(&offload->jobs, node);
+		pthread_mutex_unlock(&offload->lock);
+		job = container_of(node, rn_ssl_job_t, node);
+		job->ret = SSL_do_handshake(job->ssl);
+		/* OpenSSL error queue is per thread, so errors are fetched here */
+		job->error = SSL_get_error(job->ssl, job->ret);
+		ERR_clear_error();
+		value = 1;
+		if (write(job->done->node.fd, &value, sizeof(value)) != sizeof(value)) {
+			/* Counter can't overflow as each job is notified once */
+		}
+		pthread_mutex_lock(&offload->lock);
+	}
+	pthread_mutex_unlock(&offload->lock);
+	return NULL;
+}
+
+/**
+ * Enables handshake offload for a SSL context.
+ * Accepted connections then run handshake steps (key exchange and signature)
+ * on a pool of crypto workers, while their task is suspended. Established
+ * connections of the scheduler are not stalled by bursts of new connections.
+ *
+ * @param ctx Pointer to the SSL context
+ * @param count Number of crypto workers (RN_SSL_OFFLOAD_WORKERS if 0)
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_ssl_offload(rn_ssl_ctx_t *ctx, uint32_t count)
+{
+	uint32_t i;
+	sigset_t oldset;
+	sigset_t newset;
+	rn_ssl_offload_t *offload;
+
+	XASSERT(ctx != NULL, -1);
+	XASSERT(ctx->offload == NULL, -1);
+
+	if (count == 0) {
+		count = RN_SSL_OFFLOAD_WORKERS;
+	}
+	offload = calloc(1, sizeof(*offload));
+	if (unlikely(offload == NULL)) {
+		rn_error_set(errno);
+		return -1;
+	}
+	offload->workers = calloc(count, sizeof(*offload->workers));
+	if (unlikely(offload->workers == NULL)) {
+		rn_error_set(errno);
+		free(offload);
+		return -1;
+	}
+	rn_list(&offload->jobs, NULL);
+	pthread_mutex_init(&offload->lock, NULL);
+	pthread_cond_init(&offload->cond, NULL);
+	ctx->offload = offload;
+	/* Signals are handled by schedulers, not by crypto workers */
+	sigfillset(&newset);
+	pthread_sigmask(SIG_BLOCK, &newset, &oldset);
+	for (i = 0; i < count; i++) {
+		if (pthread_create(&offload->workers[i], NULL, rn_ssl_offload_loop, offload) != 0) {
+			pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+			rn_ssl_offload_destroy(ctx);
+			return -1;
+		}
+		offload->count++;
+	}
+	pthread_sigmask(SIG_SETMASK, &oldset, NULL);
+	return 0;
+}
+
+/**
+ * Stops crypto workers of a SSL context and frees memory.
+ * No handshake should be in progress.
+ *
+ * @param ctx Pointer to the SSL context
+ */
+void rn_ssl_offload_destroy(rn_ssl_ctx_t *ctx)
+{
+	uint32_t i;
+	rn_ssl_offload_t *offload;
+
+	XASSERTN(ctx != NULL);
+
+	offload = ctx->offload;
+	if (offload == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&offload->lock);
+	offload->stop = true;
+	pthread_cond_broadcast(&offload->cond);
+	pthread_mutex_unlock(&offload->lock);
+	for (i = 0; i < offload->count; i++) {
+		pthread_join(offload->workers[i], NULL);
+	}
+	pthread_cond_destroy(&offload->cond);
+	pthread_mutex_destroy(&offload->lock);
+	free(offload->workers);
+	free(offload);
+	ctx->offload = NULL;
+}
+
+/**
+ * Runs one handshake step on a crypto worker and waits for it.
+ * If the waiting task gets interrupted, the job is withdrawn or,
+ * when a worker already runs it, waited for synchronously as the
+ * job lives on the task stack.
+ *
+ * @param offload Pointer to the offload pool
+ * @param job Pointer to the job to run
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+static int rn_ssl_offload_step(rn_ssl_offload_t *offload, rn_ssl_job_t *job)
+{
+	uint64_t value;
+	struct pollfd pfd;
+
+	pthread_mutex_lock(&offload->lock);
+	rn_list_put(&offload->jobs, &job->node);
+	pthread_cond_signal(&offload->cond);
+	pthread_mutex_unlock(&offload->lock);
+	if (rn_eventfd_read(job->done, &value) == 0) {
+		return 0;
+	}
+	pthread_mutex_lock(&offload->lock);
+	if (rn_list_remove(&offload->jobs, &job->node) == 0) {
+		pthread_mutex_unlock(&offload->lock);
+		return -1;
+	}
+	pthread_mutex_unlock(&offload->lock);
+	pfd.fd = job->done->node.fd;
+	pfd.events = POLLIN;
+	while (poll(&pfd, 1, -1) < 0 && errno == EINTR);
+	if (read(job->done->node.fd, &value, sizeof(value)) != sizeof(value)) {
+		/* Job is done anyway */
+	}
+	return -1;
+}
+
+/**
+ * Performs a server handshake with CPU-heavy steps offloaded to crypto workers.
+ * The calling task is suspended while a worker runs OpenSSL, and waits for
+ * network events on its own scheduler between steps.
+ *
+ * @param ssl Pointer to the SSL socket
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_ssl_offload_handshake(rn_ssl_t *ssl)
+{
+	int ret;
+	rn_ssl_job_t job = { 0 };
+
+	XASSERT(ssl != NULL, -1);
+	XASSERT(ssl->ctx->offload != NULL, -1);
+
+	job.ssl = ssl->ssl;
+	job.done = rn_eventfd(ssl->socket.node.sched, 0);
+	if (unlikely(job.done == NULL)) {
+		return -1;
+	}
+	ret = -1;
+	while (rn_ssl_offload_step(ssl->ctx->offload, &job) == 0) {
+		if (job.ret == 1) {
+			ret = 0;
+			break;
+		}
+		if (job.error == SSL_ERROR_WANT_READ) {
+			if (rn_socket_waitin(&ssl->socket) != 0) {
+				break;
+			}
+		} else if (job.error == SSL_ERROR_WANT_WRITE) {
+			if (rn_socket_waitout(&ssl->socket) != 0) {
+				break;
+			}
+		} else {
+			break;
+		}
+	}
+	rn_fd_destroy(job.done);
+	return ret;
+}
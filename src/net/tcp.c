@@ -41,6 +41,109 @@ rn_socket_t *rn_tcp_client(rn_sched_t *sched, rn_addr_t *dst, uint32_t timeout)
 	return socket;
 }
 
+/**
+ * Connects a TCP socket sending the first payload in the SYN (TCP Fast Open).
+ * Without a fast open cookie from the server yet, the kernel sends a regular SYN
+ * requesting one, and the payload is written once connected.
+ *
+ * @param socket Socket pointer
+ * @param dst Destination address
+ * @param buf Payload to send
+ * @param count Payload size
+ * @param fastopen Pointer where to store whether the server accepted data in the SYN
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+static int rn_tcp_fastopen(rn_socket_t *socket, const rn_addr_t *dst, const void *buf, size_t count, bool *fastopen)
+{
+	int val;
+	ssize_t sent;
+	socklen_t size;
+	struct tcp_info info;
+
+	*fastopen = false;
+	sent = sendto(socket->node.fd, buf, count, MSG_FASTOPEN | MSG_NOSIGNAL, &dst->sa, rn_addr_len(dst));
+	if (sent < 0) {
+		switch (errno) {
+		case EINPROGRESS:
+			sent = 0;
+			break;
+		case EOPNOTSUPP:
+			/* Fast open disabled on client side */
+			if (rn_socket_connect(socket, dst) != 0) {
+				return -1;
+			}
+			return (rn_socket_write(socket, buf, count) == (ssize_t) count ? 0 : -1);
+		default:
+			rn_error_set(errno);
+			return -1;
+		}
+	}
+	if (rn_socket_waitout(socket) != 0) {
+		return -1;
+	}
+	size = sizeof(val);
+	if (getsockopt(socket->node.fd, SOL_SOCKET, SO_ERROR, (void *) &val, &size) < 0) {
+		rn_error_set(errno);
+		return -1;
+	}
+	if (val != 0) {
+		rn_error_set(val);
+		return -1;
+	}
+	if (sent > 0) {
+		size = sizeof(info);
+		if (getsockopt(socket->node.fd, IPPROTO_TCP, TCP_INFO, &info, &size) == 0) {
+			*fastopen = ((info.tcpi_options & TCPI_OPT_SYN_DATA) != 0);
+		}
+	}
+	if ((size_t) sent < count && rn_socket_write(socket, buf + sent, count - sent) != (ssize_t) (count - sent)) {
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Creates a TCP client sending a first payload along with the connection (0-RTT).
+ * The payload is carried by the SYN when the server supports TCP Fast Open and
+ * a cookie has been received from a previous connection. It is written right
+ * after the handshake otherwise.
+ *
+ * @param sched Scheduler pointer
+ * @param dst Destination address to connect to
+ * @param timeout Socket timeout
+ * @param buf First payload to send
+ * @param count Payload size
+ * @param fastopen Pointer where to store whether the payload went in the SYN (can be NULL)
+ *
+ * @return Socket pointer on success or NULL if an error occurs
+ */
+rn_socket_t *rn_tcp_client_data(rn_sched_t *sched, rn_addr_t *dst, uint32_t timeout, const void *buf, size_t count, bool *fastopen)
+{
+	bool result;
+	rn_socket_t *socket;
+
+	XASSERT(buf != NULL, NULL);
+	XASSERT(count > 0, NULL);
+
+	socket = rn_socket(sched, (IS_IPV6(dst) ? &socket_class_tcp6 : &socket_class_tcp));
+	if (unlikely(socket == NULL)) {
+		return NULL;
+	}
+	if (timeout != 0 && rn_socket_timeout(socket, timeout) != 0) {
+		rn_socket_destroy(socket);
+		return NULL;
+	}
+	if (rn_tcp_fastopen(socket, dst, buf, count, &result) != 0) {
+		rn_socket_destroy(socket);
+		return NULL;
+	}
+	if (fastopen != NULL) {
+		*fastopen = result;
+	}
+	return socket;
+}
+
 /**
  * Creates a TCP server listening to a specific address.
  *
@@ -63,3 +166,255 @@ rn_socket_t *rn_tcp_server(rn_sched_t *sched, rn_addr_t *dst)
 	}
 	return socket;
 }
+
+/**
+ * Compares two pending zero-copy buffers by sequence number.
+ *
+ * @param node1 First list node
+ * @param node2 Second list node
+ *
+ * @return An integer less than, equal or greater than zero if node1 is respectively older, equal or newer than node2
+ */
+static int rn_tcp_zccompare(rn_list_node_t *node1, rn_list_node_t *node2)
+{
+	rn_zerocopy_buffer_t *entry1 = container_of(node1, rn_zerocopy_buffer_t, node);
+	rn_zerocopy_buffer_t *entry2 = container_of(node2, rn_zerocopy_buffer_t, node);
+
+	return (int32_t) (entry1->seq - entry2->seq);
+}
+
+/**
+ * Enables zero-copy transmission (SO_ZEROCOPY) on a TCP socket.
+ * Once enabled, rn_tcp_sendzc lets the kernel send large buffers
+ * straight from user memory and reports completions on the socket error queue.
+ *
+ * @param socket Socket pointer
+ *
+ * @return 0 on success or -1 if an error occurs (e.g. unsupported by the kernel)
+ */
+int rn_tcp_zerocopy(rn_socket_t *socket)
+{
+	int enabled;
+	rn_zerocopy_t *zerocopy;
+
+	XASSERT(socket != NULL, -1);
+	XASSERT(socket->class->type == SOCK_STREAM, -1);
+
+	if (socket->zerocopy != NULL) {
+		return 0;
+	}
+	enabled = 1;
+	if (setsockopt(socket->node.fd, SOL_SOCKET, SO_ZEROCOPY, &enabled, sizeof(enabled)) != 0) {
+		rn_error_set(errno);
+		return -1;
+	}
+	zerocopy = calloc(1, sizeof(*zerocopy));
+	if (unlikely(zerocopy == NULL)) {
+		rn_error_set(errno);
+		return -1;
+	}
+	rn_list(&zerocopy->pending, rn_tcp_zccompare);
+	socket->zerocopy = zerocopy;
+	socket->node.errqueue = true;
+	return 0;
+}
+
+/**
+ * Releases zero-copy state of a socket. Buffers still in use by
+ * the kernel are destroyed: call rn_tcp_zcflush first to make sure
+ * every byte has been sent as it was at the time of rn_tcp_sendzc.
+ *
+ * @param socket Socket pointer
+ */
+void rn_tcp_zerocopy_destroy(rn_socket_t *socket)
+{
+	rn_list_node_t *node;
+	rn_zerocopy_buffer_t *entry;
+
+	XASSERTN(socket != NULL);
+	XASSERTN(socket->zerocopy != NULL);
+
+	while ((node = rn_list_pop(&socket->zerocopy->pending)) != NULL) {
+		entry = container_of(node, rn_zerocopy_buffer_t, node);
+		rn_buffer_destroy(entry->buffer);
+		free(entry);
+	}
+	free(socket->zerocopy);
+	socket->zerocopy = NULL;
+	socket->node.errqueue = false;
+}
+
+/**
+ * Reads zero-copy completions from the socket error queue, without waiting,
+ * and destroys buffers the kernel is done with.
+ * TCP completes sends in order, so each notification range extends the
+ * completed sequence.
+ *
+ * @param socket Socket pointer
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+static int rn_tcp_zcreap(rn_socket_t *socket)
+{
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	rn_zerocopy_t *zerocopy;
+	rn_list_node_t *node;
+	rn_zerocopy_buffer_t *entry;
+	struct sock_extended_err *serr;
+	char control[CMSG_SPACE(sizeof(*serr) + sizeof(struct sockaddr_in6))];
+
+	zerocopy = socket->zerocopy;
+	while (zerocopy->completed != zerocopy->sent) {
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		if (recvmsg(socket->node.fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				rn_error_set(errno);
+				return -1;
+			}
+			break;
+		}
+		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+			if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+			    !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+				continue;
+			}
+			serr = (struct sock_extended_err *) CMSG_DATA(cmsg);
+			if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+				rn_error_set(serr->ee_errno);
+				return -1;
+			}
+			zerocopy->completed += serr->ee_data - serr->ee_info + 1;
+			if ((serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) == SO_EE_CODE_ZEROCOPY_COPIED) {
+				zerocopy->copied++;
+			}
+		}
+	}
+	while ((node = rn_list_head(&zerocopy->pending)) != NULL) {
+		entry = container_of(node, rn_zerocopy_buffer_t, node);
+		if ((int32_t) (zerocopy->completed - entry->seq) < 0) {
+			break;
+		}
+		rn_list_remove(&zerocopy->pending, node);
+		rn_buffer_destroy(entry->buffer);
+		free(entry);
+	}
+	return 0;
+}
+
+/**
+ * Waits for the kernel to complete every pending zero-copy send.
+ * All buffers given to rn_tcp_sendzc are destroyed when this returns successfully.
+ *
+ * @param socket Socket pointer
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_tcp_zcflush(rn_socket_t *socket)
+{
+	XASSERT(socket != NULL, -1);
+
+	if (socket->zerocopy == NULL) {
+		return 0;
+	}
+	while (1) {
+		if (rn_tcp_zcreap(socket) != 0) {
+			return -1;
+		}
+		if (socket->zerocopy->completed == socket->zerocopy->sent) {
+			return 0;
+		}
+		if (rn_socket_waitin(socket) != 0) {
+			return -1;
+		}
+	}
+}
+
+/**
+ * Sends a buffer without copying it into the kernel (MSG_ZEROCOPY).
+ * The socket takes ownership of the buffer: it is destroyed once the kernel
+ * reports it does not need it any more, so it must not be modified after this call.
+ * Buffers smaller than RN_TCP_ZEROCOPY_THRESHOLD, or sockets without zero-copy
+ * enabled, are written the usual way and the buffer is destroyed immediately.
+ *
+ * @param socket Socket pointer
+ * @param buffer Buffer to send
+ *
+ * @return The number of bytes sent or -1 if an error occurs
+ */
+ssize_t rn_tcp_sendzc(rn_socket_t *socket, rn_buffer_t *buffer)
+{
+	char *ptr;
+	size_t size;
+	size_t count;
+	ssize_t ret;
+	ssize_t len;
+	rn_zerocopy_t *zerocopy;
+	rn_zerocopy_buffer_t *entry;
+
+	XASSERT(socket != NULL, -1);
+	XASSERT(buffer != NULL, -1);
+
+	zerocopy = socket->zerocopy;
+	if (zerocopy == NULL || rn_buffer_size(buffer) < RN_TCP_ZEROCOPY_THRESHOLD) {
+		ret = rn_socket_writeb(socket, buffer);
+		rn_buffer_destroy(buffer);
+		return ret;
+	}
+	entry = calloc(1, sizeof(*entry));
+	if (unlikely(entry == NULL)) {
+		rn_error_set(errno);
+		rn_buffer_destroy(buffer);
+		return -1;
+	}
+	ret = 0;
+	ptr = rn_buffer_ptr(buffer);
+	size = rn_buffer_size(buffer);
+	count = size;
+	while (count > 0) {
+		if (rn_socket_waitio(socket) != 0) {
+			ret = -1;
+			break;
+		}
+		len = rn_socket_throttle(socket, count);
+		if (len < 0) {
+			ret = -1;
+			break;
+		}
+		ret = rn_socket_throttled(socket, rn_socket_stat_out(socket, send(socket->node.fd, ptr, len, MSG_ZEROCOPY)));
+		if (ret == 0) {
+			ret = -1;
+			break;
+		} else if (ret < 0) {
+			if (errno == ENOBUFS && zerocopy->completed == zerocopy->sent) {
+				/* Out of option memory with nothing to release: copy the rest */
+				ret = rn_socket_write(socket, ptr, count);
+				break;
+			} else if (errno == ENOBUFS) {
+				ret = rn_tcp_zcflush(socket);
+			} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				ret = rn_socket_waitout(socket);
+			} else {
+				rn_error_set(errno);
+				ret = -1;
+			}
+			if (ret != 0) {
+				break;
+			}
+			continue;
+		}
+		zerocopy->sent++;
+		ptr += ret;
+		count -= ret;
+	}
+	/* The kernel may still reference part of the buffer, even on error */
+	entry->seq = zerocopy->sent;
+	entry->buffer = buffer;
+	rn_list_put(&zerocopy->pending, &entry->node);
+	if (rn_tcp_zcreap(socket) != 0 || ret < 0) {
+		return -1;
+	}
+	return size;
+}
@@ -0,0 +1,353 @@
+/**
+ * @file   tcp_pool.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Outbound TCP connection pool
+ *
+ *
+ */
+
+#include "rinoo/net/module.h"
+
+/**
+ * Hash function of pool destinations.
+ *
+ * @param node Pointer to the destination hash table node
+ *
+ * @return Destination hash
+ */
+static uint32_t rn_tcp_pool_hash(rn_htable_node_t *node)
+{
+	size_t i;
+	size_t len;
+	uint32_t hash;
+	const unsigned char *ptr;
+	rn_tcp_pool_dest_t *dest = container_of(node, rn_tcp_pool_dest_t, node);
+
+	if (IS_IPV6(&dest->addr)) {
+		ptr = (const unsigned char *) &dest->addr.v6.sin6_addr;
+		len = sizeof(dest->addr.v6.sin6_addr);
+	} else {
+		ptr = (const unsigned char *) &dest->addr.v4.sin_addr;
+		len = sizeof(dest->addr.v4.sin_addr);
+	}
+	/* FNV-1a over address, then port */
+	for (i = 0, hash = 2166136261U; i < len; i++) {
+		hash = (hash ^ ptr[i]) * 16777619U;
+	}
+	return (hash ^ rn_addr_getport(&dest->addr)) * 16777619U;
+}
+
+/**
+ * Compares two pool destinations.
+ *
+ * @param node1 Pointer to the first destination hash table node
+ * @param node2 Pointer to the second destination hash table node
+ *
+ * @return 0 if both destinations match, another value otherwise
+ */
+static int rn_tcp_pool_compare(rn_htable_node_t *node1, rn_htable_node_t *node2)
+{
+	rn_tcp_pool_dest_t *dest1 = container_of(node1, rn_tcp_pool_dest_t, node);
+	rn_tcp_pool_dest_t *dest2 = container_of(node2, rn_tcp_pool_dest_t, node);
+
+	if (dest1->addr.sa.sa_family != dest2->addr.sa.sa_family) {
+		return dest1->addr.sa.sa_family - dest2->addr.sa.sa_family;
+	}
+	if (IS_IPV6(&dest1->addr)) {
+		if (dest1->addr.v6.sin6_port != dest2->addr.v6.sin6_port) {
+			return dest1->addr.v6.sin6_port - dest2->addr.v6.sin6_port;
+		}
+		return memcmp(&dest1->addr.v6.sin6_addr, &dest2->addr.v6.sin6_addr, sizeof(dest1->addr.v6.sin6_addr));
+	}
+	if (dest1->addr.v4.sin_port != dest2->addr.v4.sin_port) {
+		return dest1->addr.v4.sin_port - dest2->addr.v4.sin_port;
+	}
+	return memcmp(&dest1->addr.v4.sin_addr, &dest2->addr.v4.sin_addr, sizeof(dest1->addr.v4.sin_addr));
+}
+
+/**
+ * Gets the pool entry of a destination.
+ *
+ * @param pool Pointer to the pool
+ * @param dst Destination address
+ * @param create Whether to create the entry if missing
+ *
+ * @return Pointer to the destination entry or NULL if not found or an error occurs
+ */
+static rn_tcp_pool_dest_t *rn_tcp_pool_dest(rn_tcp_pool_t *pool, const rn_addr_t *dst, bool create)
+{
+	rn_tcp_pool_dest_t dummy;
+	rn_tcp_pool_dest_t *dest;
+	rn_htable_node_t *node;
+
+	memset(&dummy, 0, sizeof(dummy));
+	if (IS_IPV6(dst)) {
+		dummy.addr.v6 = dst->v6;
+	} else {
+		dummy.addr.v4 = dst->v4;
+	}
+	node = rn_htable_get(&pool->dests, &dummy.node);
+	if (node != NULL) {
+		return container_of(node, rn_tcp_pool_dest_t, node);
+	}
+	if (!create) {
+		return NULL;
+	}
+	dest = calloc(1, sizeof(*dest));
+	if (unlikely(dest == NULL)) {
+		rn_error_set(errno);
+		return NULL;
+	}
+	dest->addr = dummy.addr;
+	rn_list(&dest->idle, NULL);
+	rn_htable_put(&pool->dests, &dest->node);
+	return dest;
+}
+
+/**
+ * Frees a pool destination and closes its idle connections.
+ *
+ * @param node Pointer to the destination hash table node
+ */
+static void rn_tcp_pool_dest_destroy(rn_htable_node_t *node)
+{
+	rn_list_node_t *lnode;
+	rn_tcp_pool_conn_t *conn;
+	rn_tcp_pool_dest_t *dest = container_of(node, rn_tcp_pool_dest_t, node);
+
+	while ((lnode = rn_list_pop(&dest->idle)) != NULL) {
+		conn = container_of(lnode, rn_tcp_pool_conn_t, dest_node);
+		rn_socket_destroy(conn->socket);
+		free(conn);
+	}
+	free(dest);
+}
+
+/**
+ * Closes an idle connection.
+ *
+ * @param pool Pointer to the pool
+ * @param conn Pointer to the idle connection
+ */
+static void rn_tcp_pool_drop(rn_tcp_pool_t *pool, rn_tcp_pool_conn_t *conn)
+{
+	rn_list_remove(&conn->dest->idle, &conn->dest_node);
+	rn_list_remove(&pool->lru, &conn->lru_node);
+	conn->dest->total--;
+	rn_socket_destroy(conn->socket);
+	free(conn);
+}
+
+/**
+ * Health check of an idle connection.
+ * The peer should not have sent anything while the connection was idle:
+ * a pending end of file means it has been closed, and pending data would
+ * be mixed up with the next response.
+ *
+ * @param socket Pointer to the idle socket
+ *
+ * @return true if the connection can be reused, false otherwise
+ */
+static bool rn_tcp_pool_alive(rn_socket_t *socket)
+{
+	char b;
+
+	if (socket->node.error != 0) {
+		return false;
+	}
+	return (recv(socket->node.fd, &b, 1, MSG_PEEK | MSG_DONTWAIT) < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+/**
+ * Reaper task closing connections idle for too long.
+ * It sleeps on the scheduler timer until the oldest idle connection expires
+ * and ends once no connection is idle anymore.
+ *
+ * @param arg Pointer to the pool
+ */
+static void rn_tcp_pool_reap(void *arg)
+{
+	uint64_t us;
+	struct timeval expiry;
+	struct timeval delay;
+	rn_tcp_pool_conn_t *conn;
+	rn_tcp_pool_t *pool = arg;
+
+	while (pool->lru.tail != NULL) {
+		conn = container_of(pool->lru.tail, rn_tcp_pool_conn_t, lru_node);
+		expiry.tv_sec = pool->idle_timeout / 1000;
+		expiry.tv_usec = (pool->idle_timeout % 1000) * 1000;
+		timeradd(&conn->since, &expiry, &expiry);
+		if (timercmp(&expiry, &pool->sched->clock, >)) {
+			timersub(&expiry, &pool->sched->clock, &delay);
+			us = (uint64_t) delay.tv_sec * 1000000 + delay.tv_usec;
+			if (rn_task_wait_us(pool->sched, us) != 0) {
+				break;
+			}
+			continue;
+		}
+		rn_tcp_pool_drop(pool, conn);
+	}
+	pool->reaper = NULL;
+}
+
+/**
+ * Creates an outbound TCP connection pool.
+ * A pool belongs to a single scheduler and is used by its tasks only,
+ * so that no locking is needed: create one pool per scheduler.
+ *
+ * @param sched Pointer to the scheduler owning the pool
+ * @param max_idle Maximum number of idle connections per destination (RN_TCP_POOL_MAX_IDLE if 0)
+ * @param max_total Maximum number of connections per destination (RN_TCP_POOL_MAX_TOTAL if 0)
+ * @param idle_timeout Time in milliseconds before idle connections get closed (RN_TCP_POOL_IDLE_TIMEOUT if 0)
+ *
+ * @return Pointer to the new pool or NULL if an error occurs
+ */
+rn_tcp_pool_t *rn_tcp_pool(rn_sched_t *sched, uint32_t max_idle, uint32_t max_total, uint32_t idle_timeout)
+{
+	rn_tcp_pool_t *pool;
+
+	XASSERT(sched != NULL, NULL);
+
+	pool = calloc(1, sizeof(*pool));
+	if (unlikely(pool == NULL)) {
+		rn_error_set(errno);
+		return NULL;
+	}
+	if (rn_htable(&pool->dests, RN_TCP_POOL_HSIZE, rn_tcp_pool_hash, rn_tcp_pool_compare) != 0) {
+		rn_error_set(errno);
+		free(pool);
+		return NULL;
+	}
+	rn_list(&pool->lru, NULL);
+	pool->sched = sched;
+	pool->max_idle = (max_idle != 0 ? max_idle : RN_TCP_POOL_MAX_IDLE);
+	pool->max_total = (max_total != 0 ? max_total : RN_TCP_POOL_MAX_TOTAL);
+	pool->idle_timeout = (idle_timeout != 0 ? idle_timeout : RN_TCP_POOL_IDLE_TIMEOUT);
+	return pool;
+}
+
+/**
+ * Destroys a connection pool and closes its idle connections.
+ * Connections still checked out are left to their users.
+ *
+ * @param pool Pointer to the pool to destroy
+ */
+void rn_tcp_pool_destroy(rn_tcp_pool_t *pool)
+{
+	XASSERTN(pool != NULL);
+
+	if (pool->reaper != NULL) {
+		rn_task_destroy(pool->reaper);
+	}
+	rn_htable_flush(&pool->dests, rn_tcp_pool_dest_destroy);
+	rn_htable_destroy(&pool->dests);
+	free(pool);
+}
+
+/**
+ * Checks out a connection to a destination.
+ * The most recently used idle connection passing the health check is reused,
+ * otherwise a new connection is made.
+ *
+ * @param pool Pointer to the pool
+ * @param dst Destination address
+ * @param timeout Socket timeout
+ *
+ * @return Socket pointer on success or NULL if an error occurs (EBUSY when max_total is reached)
+ */
+rn_socket_t *rn_tcp_pool_get(rn_tcp_pool_t *pool, rn_addr_t *dst, uint32_t timeout)
+{
+	rn_socket_t *socket;
+	rn_list_node_t *node;
+	rn_tcp_pool_conn_t *conn;
+	rn_tcp_pool_dest_t *dest;
+
+	XASSERT(pool != NULL, NULL);
+	XASSERT(dst != NULL, NULL);
+	XASSERT(rn_scheduler_self() == pool->sched, NULL);
+
+	dest = rn_tcp_pool_dest(pool, dst, true);
+	if (dest == NULL) {
+		return NULL;
+	}
+	while ((node = rn_list_head(&dest->idle)) != NULL) {
+		conn = container_of(node, rn_tcp_pool_conn_t, dest_node);
+		if (!rn_tcp_pool_alive(conn->socket)) {
+			rn_tcp_pool_drop(pool, conn);
+			continue;
+		}
+		rn_list_remove(&dest->idle, &conn->dest_node);
+		rn_list_remove(&pool->lru, &conn->lru_node);
+		socket = conn->socket;
+		free(conn);
+		if (timeout != 0 && rn_socket_timeout(socket, timeout) != 0) {
+			dest->total--;
+			rn_socket_destroy(socket);
+			return NULL;
+		}
+		pool->hits++;
+		return socket;
+	}
+	if (dest->total >= pool->max_total) {
+		rn_error_set(EBUSY);
+		return NULL;
+	}
+	/* Reserved before connecting as other tasks may check out meanwhile */
+	dest->total++;
+	socket = rn_tcp_client(pool->sched, dst, timeout);
+	if (socket == NULL) {
+		dest->total--;
+		return NULL;
+	}
+	pool->misses++;
+	return socket;
+}
+
+/**
+ * Gives a connection back to the pool.
+ * The connection is kept idle unless it should not be reused (e.g. after
+ * a protocol error) or max_idle connections are already idle.
+ *
+ * @param pool Pointer to the pool
+ * @param socket Socket returned by rn_tcp_pool_get
+ * @param dst Destination address used to get the socket
+ * @param reuse Whether the connection can be reused
+ */
+void rn_tcp_pool_release(rn_tcp_pool_t *pool, rn_socket_t *socket, rn_addr_t *dst, bool reuse)
+{
+	rn_tcp_pool_conn_t *conn;
+	rn_tcp_pool_dest_t *dest;
+
+	XASSERTN(pool != NULL);
+	XASSERTN(socket != NULL);
+	XASSERTN(dst != NULL);
+
+	dest = rn_tcp_pool_dest(pool, dst, false);
+	if (dest == NULL) {
+		rn_socket_destroy(socket);
+		return;
+	}
+	conn = NULL;
+	if (reuse && rn_list_size(&dest->idle) < pool->max_idle) {
+		conn = malloc(sizeof(*conn));
+	}
+	if (conn == NULL) {
+		dest->total--;
+		rn_socket_destroy(socket);
+		return;
+	}
+	conn->since = pool->sched->clock;
+	conn->socket = socket;
+	conn->dest = dest;
+	rn_list_put(&dest->idle, &conn->dest_node);
+	rn_list_put(&pool->lru, &conn->lru_node);
+	if (pool->reaper == NULL) {
+		pool->reaper = rn_task(pool->sched, &pool->sched->driver.main, rn_tcp_pool_reap, pool);
+		if (pool->reaper != NULL) {
+			rn_task_schedule(pool->reaper, NULL);
+		}
+	}
+}
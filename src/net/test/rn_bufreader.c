@@ -0,0 +1,116 @@
+/**
+ * @file   rn_bufreader.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for the buffered socket reader.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define MESSAGE		"HELO a\r\nMAIL b\nDATA 5\r\nhello"
+#define BIGSIZE		40000
+
+rn_sched_t *sched;
+
+void process_client(void *arg)
+{
+	char *big;
+	rn_socket_t *socket = arg;
+
+	XTEST(rn_socket_write(socket, MESSAGE, strlen(MESSAGE)) == (ssize_t) strlen(MESSAGE));
+	rn_task_wait(sched, 10);
+	XTEST(rn_socket_write(socket, "par", 3) == 3);
+	rn_task_wait(sched, 10);
+	XTEST(rn_socket_write(socket, "tial--", 6) == 6);
+	rn_task_wait(sched, 10);
+	XTEST(rn_socket_write(socket, "--X", 3) == 3);
+	big = malloc(BIGSIZE);
+	XTEST(big != NULL);
+	memset(big, 'z', BIGSIZE);
+	XTEST(rn_socket_write(socket, big, BIGSIZE) == BIGSIZE);
+	free(big);
+	XTEST(rn_socket_write(socket, "END\n", 4) == 4);
+	big = malloc(100);
+	XTEST(big != NULL);
+	memset(big, 'l', 100);
+	XTEST(rn_socket_write(socket, big, 100) == 100);
+	free(big);
+	rn_task_wait(sched, 10);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *unused(arg))
+{
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	client = rn_socket_accept(server, &addr);
+	XTEST(client != NULL);
+	rn_task_start(sched, process_client, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *unused(arg))
+{
+	char *data;
+	char *big;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_bufreader_t reader;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	XTEST(rn_bufreader(&reader, client, 64) == 0);
+	XTEST(rn_bufreader_readline(&reader, 0, &data) == 6);
+	XTEST(memcmp(data, "HELO a", 6) == 0);
+	/* Following messages came with the same read */
+	XTEST(rn_bufreader_buffered(&reader) == strlen(MESSAGE) - 8);
+	XTEST(rn_bufreader_readline(&reader, 0, &data) == 6);
+	XTEST(memcmp(data, "MAIL b", 6) == 0);
+	XTEST(rn_bufreader_readline(&reader, 0, &data) == 6);
+	XTEST(memcmp(data, "DATA 5", 6) == 0);
+	big = malloc(BIGSIZE);
+	XTEST(big != NULL);
+	XTEST(rn_bufreader_read_exact(&reader, big, 5) == 5);
+	XTEST(memcmp(big, "hello", 5) == 0);
+	XTEST(rn_bufreader_buffered(&reader) == 0);
+	/* Delimiter split across reads */
+	XTEST(rn_bufreader_read_until(&reader, "----", 0, &data) == 11);
+	XTEST(memcmp(data, "partial----", 11) == 0);
+	XTEST(rn_bufreader_peek(&reader, 1, &data) >= 1);
+	XTEST(data[0] == 'X');
+	rn_bufreader_consume(&reader, 1);
+	XTEST(rn_bufreader_read_exact(&reader, big, BIGSIZE) == BIGSIZE);
+	XTEST(big[0] == 'z' && big[BIGSIZE - 1] == 'z');
+	free(big);
+	XTEST(rn_bufreader_readline(&reader, 0, &data) == 3);
+	XTEST(memcmp(data, "END", 3) == 0);
+	XTEST(rn_bufreader_readline(&reader, 50, &data) == -1);
+	XTEST(rn_error == EMSGSIZE);
+	rn_bufreader_destroy(&reader);
+	rn_socket_destroy(client);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_task_start(sched, server_func, NULL);
+	rn_task_start(sched, client_func, NULL);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
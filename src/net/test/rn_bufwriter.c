@@ -0,0 +1,109 @@
+/**
+ * @file   rn_bufwriter.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for the buffered socket writer.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBFRAMES	100
+#define NBCHUNKS	1000
+#define CHUNKSIZE	1000
+#define THRESHOLD	1024
+#define HIGHWATER	8192
+#define TOTAL		(NBFRAMES * 6 + 3 + NBCHUNKS * CHUNKSIZE)
+
+rn_sched_t *sched;
+
+void process_client(void *arg)
+{
+	char *buf;
+	ssize_t ret;
+	size_t received;
+	rn_socket_t *socket = arg;
+
+	buf = malloc(TOTAL);
+	XTEST(buf != NULL);
+	/* Slow reader */
+	rn_task_wait(sched, 50);
+	for (received = 0; received < TOTAL; received += ret) {
+		ret = rn_socket_read(socket, buf + received, TOTAL - received);
+		XTEST(ret > 0);
+	}
+	XTEST(memcmp(buf, "frame\n", 6) == 0);
+	XTEST(memcmp(buf + NBFRAMES * 6, "abc", 3) == 0);
+	XTEST(buf[TOTAL - 1] == 'z');
+	free(buf);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *unused(arg))
+{
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	client = rn_socket_accept(server, &addr);
+	XTEST(client != NULL);
+	rn_task_start(sched, process_client, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *unused(arg))
+{
+	int i;
+	char chunk[CHUNKSIZE];
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_bufwriter_t writer;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_setopt(client, RN_SOCKET_SNDBUF, 4096) == 0);
+	XTEST(rn_bufwriter(&writer, client, THRESHOLD, HIGHWATER) == 0);
+	rn_log("small frames are gathered");
+	for (i = 0; i < NBFRAMES; i++) {
+		XTEST(rn_bufwriter_writestr(&writer, "frame\n") == 6);
+	}
+	XTEST(rn_bufwriter_pending(&writer) == NBFRAMES * 6);
+	XTEST(rn_bufwriter_flush(&writer) == 0);
+	XTEST(rn_bufwriter_pending(&writer) == 0);
+	rn_log("buffered data is sent when the task yields");
+	XTEST(rn_bufwriter_writestr(&writer, "abc") == 3);
+	XTEST(rn_bufwriter_pending(&writer) == 3);
+	rn_task_wait(sched, 1);
+	XTEST(rn_bufwriter_pending(&writer) == 0);
+	rn_log("buffered data is bounded by the high-water mark");
+	memset(chunk, 'z', sizeof(chunk));
+	for (i = 0; i < NBCHUNKS; i++) {
+		XTEST(rn_bufwriter_write(&writer, chunk, sizeof(chunk)) == sizeof(chunk));
+		XTEST(rn_bufwriter_pending(&writer) <= HIGHWATER);
+	}
+	XTEST(rn_bufwriter_flush(&writer) == 0);
+	rn_bufwriter_destroy(&writer);
+	rn_socket_destroy(client);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_task_start(sched, server_func, NULL);
+	rn_task_start(sched, client_func, NULL);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
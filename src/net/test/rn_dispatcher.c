@@ -0,0 +1,95 @@
+/**
+ * @file   rn_dispatcher.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  rn_dispatcher unit test
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBSPAWNS	3
+#define NBCLIENTS	8
+
+int nbdone = 0;
+int checker[NBSPAWNS + 1];
+rn_socket_t *server;
+rn_dispatcher_t *dispatcher;
+
+void handler_func(rn_socket_t *socket, void *arg)
+{
+	char b;
+	int id;
+
+	XTEST(arg == &checker);
+	XTEST(socket->node.sched == rn_scheduler_self());
+	id = rn_scheduler_self()->id;
+	XTEST(rn_socket_read(socket, &b, 1) == 1);
+	XTEST(b == 'a');
+	XTEST(rn_socket_write(socket, &id, sizeof(id)) == sizeof(id));
+	rn_socket_destroy(socket);
+}
+
+void acceptor_func(void *unused(arg))
+{
+	rn_dispatcher_accept(dispatcher, server);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *sched)
+{
+	int id;
+	rn_addr_t addr;
+	rn_socket_t *socket;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	socket = rn_tcp_client(sched, &addr, 0);
+	XTEST(socket != NULL);
+	XTEST(rn_socket_write(socket, "a", 1) == 1);
+	XTEST(rn_socket_read(socket, &id, sizeof(id)) == sizeof(id));
+	XTEST(id >= 0 && id <= NBSPAWNS);
+	checker[id]++;
+	rn_socket_destroy(socket);
+	if (++nbdone == NBCLIENTS) {
+		rn_scheduler_stop(sched);
+	}
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	int i;
+	rn_addr_t addr;
+	rn_sched_t *sched;
+	rn_dispatch_gauges_t gauges;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	XTEST(rn_spawn(sched, NBSPAWNS) == 0);
+	dispatcher = rn_dispatcher(sched, RN_DISPATCH_RR, handler_func, &checker);
+	XTEST(dispatcher != NULL);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	XTEST(rn_task_start(sched, acceptor_func, NULL) == 0);
+	for (i = 0; i < NBCLIENTS; i++) {
+		XTEST(rn_task_start(sched, client_func, sched) == 0);
+	}
+	rn_scheduler_loop(sched);
+	XTEST(nbdone == NBCLIENTS);
+	for (i = 0; i <= NBSPAWNS; i++) {
+		XTEST(rn_dispatcher_gauges(dispatcher, i, &gauges) == 0);
+		rn_log("scheduler %d: dispatched %lu, handled %d", i, gauges.dispatched, checker[i]);
+		XTEST(gauges.dispatched == NBCLIENTS / (NBSPAWNS + 1));
+		XTEST(checker[i] == NBCLIENTS / (NBSPAWNS + 1));
+	}
+	rn_dispatcher_destroy(dispatcher);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,154 @@
+/**
+ * @file   rn_socket_admission.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for scheduler admission control on accept.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+/* Server task, first client and its handler */
+#define MAX_TASKS	3
+
+int nbdone;
+rn_socket_t *server;
+rn_admission_mode_t mode;
+
+void process_client(void *arg)
+{
+	char b;
+	rn_socket_t *socket = arg;
+
+	XTEST(rn_socket_read(socket, &b, 1) == 1);
+	XTEST(rn_socket_write(socket, &b, 1) == 1);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *sched)
+{
+	rn_socket_t *client;
+
+	while ((client = rn_socket_accept(server, NULL)) != NULL) {
+		rn_log("server - client accepted");
+		XTEST(rn_task_start(sched, process_client, client) == 0);
+	}
+	rn_socket_destroy(server);
+}
+
+void client_func(void *arg)
+{
+	char b;
+	rn_addr_t addr;
+	rn_sched_t *sched;
+	rn_socket_t *socket;
+	char expected = *(char *) arg;
+
+	sched = rn_scheduler_self();
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	socket = rn_tcp_client(sched, &addr, 0);
+	if (mode == RN_ADMISSION_REJECT && expected == 'b') {
+		/* Reset can be received while connecting */
+		rn_log("client %c - expecting reset", expected);
+		if (socket != NULL) {
+			rn_socket_write(socket, &expected, 1);
+			XTEST(rn_socket_read(socket, &b, 1) <= 0);
+		}
+	} else {
+		XTEST(socket != NULL);
+		XTEST(rn_socket_write(socket, &expected, 1) == 1);
+		rn_log("client %c - expecting answer", expected);
+		XTEST(rn_socket_read(socket, &b, 1) == 1);
+		XTEST(b == expected);
+	}
+	if (socket != NULL) {
+		rn_socket_destroy(socket);
+	}
+	if (++nbdone == 2) {
+		rn_scheduler_stop(sched);
+	}
+}
+
+void run(rn_admission_mode_t admission)
+{
+	rn_addr_t addr;
+	rn_sched_t *sched;
+
+	nbdone = 0;
+	mode = admission;
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	XTEST(rn_scheduler_admission(sched, mode, MAX_TASKS, 0) == 0);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	XTEST(rn_task_start(sched, server_func, sched) == 0);
+	XTEST(rn_task_start(sched, client_func, "a") == 0);
+	XTEST(rn_task_start(sched, client_func, "b") == 0);
+	rn_scheduler_loop(sched);
+	rn_log("paused: %lu, rejected: %lu", sched->admission.paused, sched->admission.rejected);
+	if (mode == RN_ADMISSION_PAUSE) {
+		XTEST(sched->admission.paused > 0);
+		XTEST(sched->admission.rejected == 0);
+	} else {
+		XTEST(sched->admission.paused == 0);
+		XTEST(sched->admission.rejected == 1);
+	}
+	rn_scheduler_destroy(sched);
+}
+
+void busy_func(void *sched)
+{
+	rn_task_wait(sched, 500);
+}
+
+void timeout_func(void *sched)
+{
+	rn_addr_t addr;
+	struct timeval end;
+	struct timeval diff;
+	struct timeval start;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	gettimeofday(&start, NULL);
+	XTEST(rn_socket_timeout(server, 100) == 0);
+	XTEST(rn_socket_accept(server, NULL) == NULL);
+	XTEST(rn_error == ETIMEDOUT);
+	gettimeofday(&end, NULL);
+	timersub(&end, &start, &diff);
+	rn_log("paused accept timed out after %ld ms", diff.tv_sec * 1000 + diff.tv_usec / 1000);
+	XTEST(diff.tv_sec == 0 && diff.tv_usec < 400000);
+	rn_socket_destroy(server);
+}
+
+void run_timeout(void)
+{
+	rn_sched_t *sched;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	/* Accepting task and busy task */
+	XTEST(rn_scheduler_admission(sched, RN_ADMISSION_PAUSE, 1, 0) == 0);
+	XTEST(rn_task_start(sched, busy_func, sched) == 0);
+	XTEST(rn_task_start(sched, timeout_func, sched) == 0);
+	rn_scheduler_loop(sched);
+	XTEST(sched->admission.paused == 1);
+	rn_scheduler_destroy(sched);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	run(RN_ADMISSION_PAUSE);
+	run(RN_ADMISSION_REJECT);
+	run_timeout();
+	XPASS();
+}
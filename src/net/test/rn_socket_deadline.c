@@ -0,0 +1,129 @@
+/**
+ * @file   rn_socket_deadline.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for socket read, write and idle deadlines.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBBYTES		5
+#define BIGSIZE		(16 * 1024 * 1024)
+
+rn_sched_t *sched;
+
+static uint64_t elapsed(struct timeval *start)
+{
+	struct timeval now;
+	struct timeval diff;
+
+	gettimeofday(&now, NULL);
+	timersub(&now, start, &diff);
+	return diff.tv_sec * 1000 + diff.tv_usec / 1000;
+}
+
+void process_client(void *arg)
+{
+	int i;
+	char a;
+	struct timeval start;
+	rn_socket_t *socket = arg;
+
+	rn_log("read deadline");
+	XTEST(rn_socket_deadline(socket, 50, 0, 0) == 0);
+	gettimeofday(&start, NULL);
+	XTEST(rn_socket_read(socket, &a, 1) == -1);
+	XTEST(rn_error == ETIMEDOUT);
+	XTEST(elapsed(&start) >= 40);
+	rn_log("idle deadline, the socket can still be used after a timeout");
+	XTEST(rn_socket_deadline(socket, 0, 0, 100) == 0);
+	for (i = 0; i < NBBYTES; i++) {
+		XTEST(rn_socket_read(socket, &a, 1) == 1);
+	}
+	gettimeofday(&start, NULL);
+	XTEST(rn_socket_read(socket, &a, 1) == -1);
+	XTEST(rn_error == ETIMEDOUT);
+	XTEST(elapsed(&start) >= 80);
+	rn_log("idle deadline, I/O without waiting restarts the idle period");
+	XTEST(rn_socket_deadline(socket, 0, 0, 0) == 0);
+	XTEST(rn_socket_read(socket, &a, 1) == 1);
+	XTEST(rn_socket_deadline(socket, 0, 0, 100) == 0);
+	/* Response takes longer than the idle period to produce */
+	usleep(150000);
+	XTEST(rn_socket_write(socket, "r", 1) == 1);
+	XTEST(rn_socket_read(socket, &a, 1) == 1);
+	XTEST(a == 'z');
+	/* Let the client fill the socket buffers */
+	rn_task_wait(sched, 500);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *unused(arg))
+{
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	client = rn_socket_accept(server, &addr);
+	XTEST(client != NULL);
+	rn_task_start(sched, process_client, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *unused(arg))
+{
+	int i;
+	char a;
+	char *big;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	struct timeval start;
+
+	big = malloc(BIGSIZE);
+	XTEST(big != NULL);
+	memset(big, 'x', BIGSIZE);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	rn_task_wait(sched, 100);
+	for (i = 0; i < NBBYTES; i++) {
+		XTEST(rn_socket_write(client, "x", 1) == 1);
+		rn_task_wait(sched, 60);
+	}
+	rn_task_wait(sched, 250);
+	XTEST(rn_socket_write(client, "y", 1) == 1);
+	XTEST(rn_socket_read(client, &a, 1) == 1);
+	rn_task_wait(sched, 20);
+	XTEST(rn_socket_write(client, "z", 1) == 1);
+	rn_log("write deadline");
+	XTEST(rn_socket_setopt(client, RN_SOCKET_SNDBUF, 4096) == 0);
+	XTEST(rn_socket_deadline(client, 0, 50, 0) == 0);
+	gettimeofday(&start, NULL);
+	XTEST(rn_socket_write(client, big, BIGSIZE) == -1);
+	XTEST(rn_error == ETIMEDOUT);
+	XTEST(elapsed(&start) >= 40);
+	free(big);
+	rn_socket_destroy(client);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_task_start(sched, server_func, NULL);
+	rn_task_start(sched, client_func, NULL);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
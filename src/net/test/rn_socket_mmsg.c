@@ -0,0 +1,113 @@
+/**
+ * @file   rn_socket_mmsg.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for rn_socket_recvmmsg and rn_socket_sendmmsg.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBMSGS		100
+#define MSGSIZE		16
+
+extern const rn_socket_class_t socket_class_udp;
+
+char bufs[NBMSGS][MSGSIZE];
+rn_msg_t msgs[NBMSGS];
+
+void server_func(void *arg)
+{
+	int i;
+	int ret;
+	int received;
+	char expected[MSGSIZE];
+	rn_msg_t *msgs;
+	rn_socket_t *server = arg;
+
+	msgs = calloc(NBMSGS, sizeof(*msgs));
+	XTEST(msgs != NULL);
+	for (i = 0; i < NBMSGS; i++) {
+		msgs[i].buf = malloc(MSGSIZE);
+		msgs[i].size = MSGSIZE;
+		XTEST(msgs[i].buf != NULL);
+	}
+	received = 0;
+	while (received < NBMSGS) {
+		ret = rn_socket_recvmmsg(server, &msgs[received], NBMSGS - received);
+		XTEST(ret > 0);
+		rn_log("server - received %d datagrams", ret);
+		received += ret;
+	}
+	for (i = 0; i < NBMSGS; i++) {
+		snprintf(expected, sizeof(expected), "msg %d", i);
+		XTEST(msgs[i].len == strlen(expected));
+		XTEST(memcmp(msgs[i].buf, expected, msgs[i].len) == 0);
+		XTEST(IS_IPV4(&msgs[i].addr));
+	}
+	rn_log("server - echoing datagrams");
+	XTEST(rn_socket_sendmmsg(server, msgs, NBMSGS) == NBMSGS);
+	for (i = 0; i < NBMSGS; i++) {
+		free(msgs[i].buf);
+	}
+	free(msgs);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *sched)
+{
+	int i;
+	int ret;
+	int received;
+	rn_addr_t addr;
+	rn_socket_t *socket;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	socket = rn_udp_client(sched, &addr);
+	XTEST(socket != NULL);
+	for (i = 0; i < NBMSGS; i++) {
+		msgs[i].buf = bufs[i];
+		msgs[i].len = snprintf(bufs[i], MSGSIZE, "msg %d", i);
+		msgs[i].size = MSGSIZE;
+		msgs[i].addr.sa.sa_family = AF_UNSPEC;
+	}
+	rn_log("client - sending %d datagrams", NBMSGS);
+	XTEST(rn_socket_sendmmsg(socket, msgs, NBMSGS) == NBMSGS);
+	memset(bufs, 0, sizeof(bufs));
+	received = 0;
+	while (received < NBMSGS) {
+		ret = rn_socket_recvmmsg(socket, &msgs[received], NBMSGS - received);
+		XTEST(ret > 0);
+		received += ret;
+	}
+	for (i = 0; i < NBMSGS; i++) {
+		XTEST(atoi(bufs[i] + 4) == i);
+	}
+	rn_socket_destroy(socket);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	rn_addr_t addr;
+	rn_sched_t *sched;
+	rn_socket_t *server;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	server = rn_socket(sched, &socket_class_udp);
+	XTEST(server != NULL);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	XTEST(rn_socket_bind(server, &addr, 0) == 0);
+	XTEST(rn_task_start(sched, server_func, server) == 0);
+	XTEST(rn_task_start(sched, client_func, sched) == 0);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,163 @@
+/**
+ * @file   rn_socket_ratelimit.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for socket rate limiting.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define RATE		(100 * 1024)
+#define BURST		(10 * 1024)
+#define TOTAL		(50 * 1024)
+#define NBCLIENTS	2
+#define NBVECS		4
+#define TIMEOUT		200
+
+rn_sched_t *sched;
+rn_ratelimit_t *group;
+int nbdone = 0;
+
+/* Time needed to send TOTAL bytes once the burst is spent, minus some margin */
+#define MINTIME		((TOTAL - BURST) * 1000 / RATE - 50)
+
+void process_client(void *arg)
+{
+	char buf[4096];
+	rn_socket_t *socket = arg;
+
+	while (rn_socket_read(socket, buf, sizeof(buf)) > 0);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *unused(arg))
+{
+	int i;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	for (i = 0; i < NBCLIENTS + 3; i++) {
+		client = rn_socket_accept(server, &addr);
+		XTEST(client != NULL);
+		rn_task_start(sched, process_client, client);
+	}
+	rn_socket_destroy(server);
+}
+
+static uint64_t elapsed_ms(struct timeval *start)
+{
+	struct timeval now;
+	struct timeval diff;
+
+	gettimeofday(&now, NULL);
+	timersub(&now, start, &diff);
+	return diff.tv_sec * 1000 + diff.tv_usec / 1000;
+}
+
+void group_client(void *unused(arg))
+{
+	char *buf;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	struct timeval start;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_ratelimit_group(client, group) == 0);
+	buf = calloc(1, TOTAL / NBCLIENTS);
+	XTEST(buf != NULL);
+	gettimeofday(&start, NULL);
+	XTEST(rn_socket_write(client, buf, TOTAL / NBCLIENTS) == TOTAL / NBCLIENTS);
+	free(buf);
+	rn_socket_destroy(client);
+	if (++nbdone == NBCLIENTS) {
+		rn_log("group: %llu ms", (unsigned long long) elapsed_ms(&start));
+		XTEST(elapsed_ms(&start) >= MINTIME);
+		rn_ratelimit_destroy(group);
+	}
+}
+
+void client_func(void *unused(arg))
+{
+	int i;
+	char *buf;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	struct timeval start;
+	rn_buffer_t *buffers[NBVECS];
+	rn_buffer_t buffer[NBVECS];
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_ratelimit(client, RATE, BURST) == 0);
+	buf = calloc(1, TOTAL);
+	XTEST(buf != NULL);
+	rn_log("a socket sends at its own rate");
+	gettimeofday(&start, NULL);
+	XTEST(rn_socket_write(client, buf, TOTAL) == TOTAL);
+	rn_log("socket: %llu ms", (unsigned long long) elapsed_ms(&start));
+	XTEST(elapsed_ms(&start) >= MINTIME);
+	rn_log("removing the limit");
+	XTEST(rn_socket_ratelimit(client, 0, 0) == 0);
+	gettimeofday(&start, NULL);
+	XTEST(rn_socket_write(client, buf, TOTAL) == TOTAL);
+	XTEST(elapsed_ms(&start) < MINTIME);
+	rn_socket_destroy(client);
+	rn_log("vectored writes are limited too");
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_ratelimit(client, RATE, BURST) == 0);
+	for (i = 0; i < NBVECS; i++) {
+		rn_buffer_static(&buffer[i], buf + i * (TOTAL / NBVECS), TOTAL / NBVECS);
+		buffers[i] = &buffer[i];
+	}
+	gettimeofday(&start, NULL);
+	XTEST(rn_socket_writev(client, buffers, NBVECS) == TOTAL);
+	rn_log("writev: %llu ms", (unsigned long long) elapsed_ms(&start));
+	XTEST(elapsed_ms(&start) >= MINTIME);
+	rn_socket_destroy(client);
+	rn_log("a socket timeout still fires while throttled");
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_ratelimit(client, RATE / 10, BURST / 10) == 0);
+	gettimeofday(&start, NULL);
+	XTEST(rn_socket_timeout(client, TIMEOUT) == 0);
+	XTEST(rn_socket_write(client, buf, TOTAL) == -1);
+	XTEST(rn_error == ETIMEDOUT);
+	rn_log("timeout: %llu ms", (unsigned long long) elapsed_ms(&start));
+	XTEST(elapsed_ms(&start) >= TIMEOUT - 10 && elapsed_ms(&start) < TIMEOUT * 2);
+	free(buf);
+	rn_socket_destroy(client);
+	rn_log("sockets of a group share the group rate");
+	group = rn_ratelimit(RATE, BURST);
+	XTEST(group != NULL);
+	for (i = 0; i < NBCLIENTS; i++) {
+		rn_task_start(sched, group_client, NULL);
+	}
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_task_start(sched, server_func, NULL);
+	rn_task_start(sched, client_func, NULL);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XTEST(nbdone == NBCLIENTS);
+	XPASS();
+}
@@ -0,0 +1,112 @@
+/**
+ * @file   rn_socket_setopt.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for socket options and auto-cork mode.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+rn_sched_t *sched;
+
+void process_client(void *arg)
+{
+	int value;
+	char b;
+	rn_socket_t *socket = arg;
+
+	XTEST(rn_socket_getopt(socket, RN_SOCKET_AUTOCORK, &value) == 0);
+	XTEST(value == 1);
+	XTEST(rn_socket_write(socket, "head", 4) == 4);
+	XTEST(rn_socket_getopt(socket, RN_SOCKET_CORK, &value) == 0);
+	XTEST(value == 1);
+	XTEST(rn_socket_write(socket, "body", 4) == 4);
+	/* Yielding sends what has been corked */
+	XTEST(rn_task_wait(sched, 1) == 0);
+	XTEST(rn_socket_getopt(socket, RN_SOCKET_CORK, &value) == 0);
+	XTEST(value == 0);
+	XTEST(rn_socket_write(socket, "tail", 4) == 4);
+	XTEST(rn_socket_getopt(socket, RN_SOCKET_CORK, &value) == 0);
+	XTEST(value == 1);
+	/* Reading sends what has been corked */
+	XTEST(rn_socket_read(socket, &b, 1) == 1);
+	XTEST(rn_socket_getopt(socket, RN_SOCKET_CORK, &value) == 0);
+	XTEST(value == 0);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *unused(arg))
+{
+	int value;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	XTEST(rn_socket_setopt(server, RN_SOCKET_AUTOCORK, 1) == 0);
+	XTEST(rn_socket_setopt(server, RN_SOCKET_DEFER_ACCEPT, 1) == 0);
+	XTEST(rn_socket_getopt(server, RN_SOCKET_DEFER_ACCEPT, &value) == 0);
+	XTEST(value > 0);
+	client = rn_socket_accept(server, &addr);
+	XTEST(client != NULL);
+	rn_task_start(sched, process_client, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *unused(arg))
+{
+	int value;
+	char buf[12];
+	ssize_t ret;
+	size_t received;
+	rn_addr_t addr;
+	rn_socket_t *client;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	/* Class default is the system one */
+	XTEST(rn_socket_getopt(client, RN_SOCKET_NODELAY, &value) == 0);
+	XTEST(value == 0);
+	XTEST(rn_socket_setopt(client, RN_SOCKET_NODELAY, 1) == 0);
+	XTEST(rn_socket_getopt(client, RN_SOCKET_NODELAY, &value) == 0);
+	XTEST(value == 1);
+	XTEST(rn_socket_setopt(client, RN_SOCKET_SNDBUF, 64 * 1024) == 0);
+	XTEST(rn_socket_getopt(client, RN_SOCKET_SNDBUF, &value) == 0);
+	XTEST(value >= 64 * 1024);
+	XTEST(rn_socket_setopt(client, RN_SOCKET_RCVBUF, 64 * 1024) == 0);
+	XTEST(rn_socket_setopt(client, RN_SOCKET_NOTSENT_LOWAT, 16 * 1024) == 0);
+	XTEST(rn_socket_getopt(client, RN_SOCKET_NOTSENT_LOWAT, &value) == 0);
+	XTEST(value == 16 * 1024);
+	XTEST(rn_socket_setopt(client, RN_SOCKET_NBOPTS, 1) == -1);
+	XTEST(rn_socket_getopt(client, RN_SOCKET_AUTOCORK, &value) == 0);
+	XTEST(value == 0);
+	XTEST(rn_socket_write(client, "x", 1) == 1);
+	for (received = 0; received < sizeof(buf); received += ret) {
+		ret = rn_socket_read(client, buf + received, sizeof(buf) - received);
+		XTEST(ret > 0);
+	}
+	XTEST(memcmp(buf, "headbodytail", 12) == 0);
+	rn_socket_destroy(client);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_task_start(sched, server_func, NULL);
+	rn_task_start(sched, client_func, NULL);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,95 @@
+/**
+ * @file   rn_socket_stats.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for socket I/O accounting.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+rn_sched_t *sched;
+
+void process_client(void *arg)
+{
+	char b[5];
+	const rn_stats_t *stats;
+	rn_socket_t *socket = arg;
+
+	/* Waits for the client, which writes after 20ms */
+	XTEST(rn_socket_read(socket, b, 5) == 5);
+	stats = rn_socket_stats(socket);
+	XTEST(stats->bytes_in == 5);
+	XTEST(stats->reads >= 2);
+	XTEST(stats->eagain >= 1);
+	XTEST(stats->waitin >= 1);
+	XTEST(stats->suspended >= 10000);
+	XTEST(rn_socket_write(socket, "world", 5) == 5);
+	XTEST(stats->bytes_out == 5);
+	XTEST(stats->writes == 1);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *unused(arg))
+{
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	client = rn_socket_accept(server, &addr);
+	XTEST(client != NULL);
+	rn_task_start(sched, process_client, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *unused(arg))
+{
+	char b[5];
+	rn_addr_t addr;
+	rn_socket_t *client;
+	const rn_stats_t *stats;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	rn_task_wait(sched, 20);
+	XTEST(rn_socket_write(client, "hello", 5) == 5);
+	XTEST(rn_socket_read(client, b, 5) == 5);
+	stats = rn_socket_stats(client);
+	XTEST(stats->bytes_out == 5);
+	XTEST(stats->bytes_in == 5);
+	rn_socket_destroy(client);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	const rn_stats_t *total;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	if (rn_scheduler_stats_enable(sched, true) != 0) {
+		/* Built with RINOO_NO_STATS */
+		XTEST(rn_error == ENOTSUP);
+		rn_scheduler_destroy(sched);
+		XPASS();
+	}
+	rn_task_start(sched, server_func, NULL);
+	rn_task_start(sched, client_func, NULL);
+	rn_scheduler_loop(sched);
+	total = rn_scheduler_stats(sched);
+	XTEST(total->bytes_in == 10);
+	XTEST(total->bytes_out == 10);
+	XTEST(total->waitin >= 2);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
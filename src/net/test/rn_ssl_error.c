@@ -0,0 +1,85 @@
+/**
+ * @file   rn_ssl_error.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for fatal SSL errors.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+rn_sched_t *sched;
+
+void process_client(void *arg)
+{
+	char b;
+	rn_socket_t *socket = arg;
+
+	XTEST(rn_socket_write(socket, "a", 1) == 1);
+	rn_log("server - sending a record which is not valid");
+	XTEST(write(socket->node.fd, "\x17\x03\x03\x00\x05garbage", 12) == 12);
+	XTEST(rn_socket_read(socket, &b, 1) == -1);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *arg)
+{
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+	rn_ssl_ctx_t *ctx = arg;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_ssl_server(sched, ctx, &addr);
+	XTEST(server != NULL);
+	client = rn_socket_accept(server, &addr);
+	XTEST(client != NULL);
+	rn_task_start(sched, process_client, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *arg)
+{
+	char a;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_ssl_ctx_t *ctx = arg;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_ssl_client(sched, ctx, &addr, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_read(client, &a, 1) == 1);
+	XTEST(rn_ssl_get(client)->fatal == false);
+	rn_log("client - reading a record which is not valid");
+	XTEST(rn_socket_read(client, &a, 1) == -1);
+	XTEST(rn_error == EPROTO);
+	XTEST(rn_ssl_get(client)->fatal == true);
+	/* Errors do not remain for other connections of this thread */
+	XTEST(ERR_peek_error() == 0);
+	/* No shutdown and no session kept after a fatal error */
+	rn_socket_destroy(client);
+	XTEST(ERR_peek_error() == 0);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	rn_ssl_ctx_t *ctx;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	ctx = rn_ssl_context();
+	XTEST(ctx != NULL);
+	rn_task_start(sched, server_func, ctx);
+	rn_task_start(sched, client_func, ctx);
+	rn_scheduler_loop(sched);
+	rn_ssl_context_destroy(ctx);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
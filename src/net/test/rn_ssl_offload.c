@@ -0,0 +1,125 @@
+/**
+ * @file   rn_ssl_offload.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for TLS handshake offload.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBCLIENTS	5
+
+rn_sched_t *sched;
+pthread_t scheduler_thread;
+int ticks = 0;
+int nbclients = 0;
+/* Server handshake steps run on the scheduler thread, and off it */
+int steps_on = 0;
+int steps_off = 0;
+
+void info_callback(const SSL *unused(ssl), int where, int unused(ret))
+{
+	if ((where & (SSL_CB_HANDSHAKE_START | SSL_CB_ACCEPT_LOOP | SSL_CB_HANDSHAKE_DONE)) == 0) {
+		return;
+	}
+	if (pthread_equal(pthread_self(), scheduler_thread)) {
+		__atomic_add_fetch(&steps_on, 1, __ATOMIC_RELAXED);
+	} else {
+		__atomic_add_fetch(&steps_off, 1, __ATOMIC_RELAXED);
+	}
+}
+
+void process_client(void *arg)
+{
+	char b;
+	rn_socket_t *socket = arg;
+
+	XTEST(rn_socket_read(socket, &b, 1) == 1);
+	XTEST(rn_socket_write(socket, &b, 1) == 1);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *arg)
+{
+	int i;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+	rn_ssl_ctx_t *ctx = arg;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_ssl_server(sched, ctx, &addr);
+	XTEST(server != NULL);
+	for (i = 0; i < NBCLIENTS; i++) {
+		client = rn_socket_accept(server, &addr);
+		XTEST(client != NULL);
+		rn_task_start(sched, process_client, client);
+	}
+	rn_socket_destroy(server);
+}
+
+void client_func(void *arg)
+{
+	char b;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_ssl_ctx_t *ctx = arg;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_ssl_client(sched, ctx, &addr, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_write(client, "x", 1) == 1);
+	XTEST(rn_socket_read(client, &b, 1) == 1);
+	XTEST(b == 'x');
+	rn_socket_destroy(client);
+	nbclients++;
+}
+
+void ticker_func(void *unused(arg))
+{
+	while (nbclients < NBCLIENTS) {
+		ticks++;
+		rn_task_wait(sched, 1);
+	}
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	int i;
+	rn_ssl_ctx_t *client;
+	rn_ssl_ctx_t *server;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	scheduler_thread = pthread_self();
+	server = rn_ssl_context();
+	XTEST(server != NULL);
+	SSL_CTX_set_info_callback(server->ctx, info_callback);
+	XTEST(rn_ssl_offload(server, 2) == 0);
+	client = rn_ssl_context();
+	XTEST(client != NULL);
+	rn_task_start(sched, server_func, server);
+	for (i = 0; i < NBCLIENTS; i++) {
+		rn_task_start(sched, client_func, client);
+	}
+	rn_task_start(sched, ticker_func, NULL);
+	rn_scheduler_loop(sched);
+	XTEST(nbclients == NBCLIENTS);
+	rn_log("scheduler ticked %d times during handshakes", ticks);
+	XTEST(ticks > 0);
+	rn_log("server handshake steps: %d offloaded, %d on the scheduler thread", steps_off, steps_on);
+	XTEST(steps_off > 0);
+	XTEST(steps_on == 0);
+	rn_ssl_context_destroy(client);
+	rn_ssl_context_destroy(server);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
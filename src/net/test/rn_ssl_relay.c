@@ -0,0 +1,137 @@
+/**
+ * @file   rn_ssl_relay.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for rn_socket_relay between a SSL socket and a TCP socket.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBCHUNKS	16
+#define CHUNK_SIZE	(16 * 1024)
+
+bool relayed = false;
+
+void echo_func(void *arg)
+{
+	char buf[1024];
+	ssize_t ret;
+	rn_socket_t *client = arg;
+
+	while ((ret = rn_socket_read(client, buf, sizeof(buf))) > 0) {
+		XTEST(rn_socket_write(client, buf, ret) == ret);
+	}
+	rn_log("backend - client closed");
+	rn_socket_destroy(client);
+}
+
+void backend_func(void *arg)
+{
+	rn_addr_t from;
+	rn_socket_t *client;
+	rn_socket_t *server = arg;
+
+	client = rn_socket_accept(server, &from);
+	XTEST(client != NULL);
+	rn_task_start(server->node.sched, echo_func, client);
+	rn_socket_destroy(server);
+}
+
+void relay_func(void *arg)
+{
+	rn_addr_t addr;
+	rn_socket_t *backend;
+	rn_socket_t *client = arg;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	backend = rn_tcp_client(client->node.sched, &addr, 0);
+	XTEST(backend != NULL);
+	XTEST(rn_socket_relay(client, backend) == 0);
+	rn_log("proxy - relay done");
+	relayed = true;
+	rn_socket_destroy(backend);
+	rn_socket_destroy(client);
+}
+
+void proxy_func(void *arg)
+{
+	rn_addr_t from;
+	rn_socket_t *client;
+	rn_socket_t *server = arg;
+
+	client = rn_socket_accept(server, &from);
+	XTEST(client != NULL);
+	rn_task_start(server->node.sched, relay_func, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *arg)
+{
+	int i;
+	char *in;
+	char *out;
+	size_t j;
+	size_t received;
+	ssize_t ret;
+	rn_addr_t addr;
+	rn_socket_t *socket;
+	rn_ssl_ctx_t *ctx = arg;
+
+	in = malloc(CHUNK_SIZE);
+	out = malloc(CHUNK_SIZE);
+	XTEST(in != NULL && out != NULL);
+	rn_addr4(&addr, "127.0.0.1", 4243);
+	socket = rn_ssl_client(rn_scheduler_self(), ctx, &addr, 0);
+	XTEST(socket != NULL);
+	for (i = 0; i < NBCHUNKS; i++) {
+		for (j = 0; j < CHUNK_SIZE; j++) {
+			out[j] = 'a' + (i + j) % 26;
+		}
+		XTEST(rn_socket_write(socket, out, CHUNK_SIZE) == CHUNK_SIZE);
+		for (received = 0; received < CHUNK_SIZE; received += ret) {
+			ret = rn_socket_read(socket, in + received, CHUNK_SIZE - received);
+			XTEST(ret > 0);
+		}
+		XTEST(memcmp(in, out, CHUNK_SIZE) == 0);
+	}
+	rn_log("client - %d chunks echoed through the SSL proxy", NBCHUNKS);
+	rn_socket_destroy(socket);
+	free(in);
+	free(out);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	rn_addr_t addr;
+	rn_sched_t *sched;
+	rn_ssl_ctx_t *ctx;
+	rn_socket_t *proxy;
+	rn_socket_t *backend;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	ctx = rn_ssl_context();
+	XTEST(ctx != NULL);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	backend = rn_tcp_server(sched, &addr);
+	XTEST(backend != NULL);
+	rn_addr4(&addr, "127.0.0.1", 4243);
+	proxy = rn_ssl_server(sched, ctx, &addr);
+	XTEST(proxy != NULL);
+	XTEST(rn_task_start(sched, backend_func, backend) == 0);
+	XTEST(rn_task_start(sched, proxy_func, proxy) == 0);
+	XTEST(rn_task_start(sched, client_func, ctx) == 0);
+	rn_scheduler_loop(sched);
+	XTEST(relayed == true);
+	rn_ssl_context_destroy(ctx);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
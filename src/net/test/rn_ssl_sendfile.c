@@ -0,0 +1,121 @@
+/**
+ * @file   rn_ssl_sendfile.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for sendfile and writev on SSL sockets.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define FILE_SIZE	(256 * 1024)
+
+int fd;
+rn_sched_t *sched;
+
+char expected(size_t i)
+{
+	return 'a' + i % 26;
+}
+
+void process_client(void *arg)
+{
+	rn_buffer_t head;
+	rn_buffer_t tail;
+	rn_buffer_t *buffers[2];
+	rn_socket_t *socket = arg;
+
+	rn_log("server - kTLS %s", (rn_ssl_ktls(socket) ? "enabled" : "not available"));
+	rn_buffer_set(&head, "head:");
+	rn_buffer_set(&tail, ":tail");
+	buffers[0] = &head;
+	buffers[1] = &tail;
+	XTEST(rn_socket_writev(socket, buffers, 2) == 10);
+	XTEST(rn_socket_sendfile(socket, fd, 0, FILE_SIZE) == FILE_SIZE);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *arg)
+{
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+	rn_ssl_ctx_t *ctx = arg;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_ssl_server(sched, ctx, &addr);
+	XTEST(server != NULL);
+	client = rn_socket_accept(server, &addr);
+	XTEST(client != NULL);
+	rn_task_start(sched, process_client, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *arg)
+{
+	char *buf;
+	size_t i;
+	size_t received;
+	ssize_t ret;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_ssl_ctx_t *ctx = arg;
+
+	buf = malloc(FILE_SIZE);
+	XTEST(buf != NULL);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_ssl_client(sched, ctx, &addr, 0);
+	XTEST(client != NULL);
+	for (received = 0; received < 10; received += ret) {
+		ret = rn_socket_read(client, buf + received, 10 - received);
+		XTEST(ret > 0);
+	}
+	XTEST(memcmp(buf, "head::tail", 10) == 0);
+	for (received = 0; received < FILE_SIZE; received += ret) {
+		ret = rn_socket_read(client, buf + received, FILE_SIZE - received);
+		XTEST(ret > 0);
+	}
+	for (i = 0; i < FILE_SIZE; i++) {
+		XTEST(buf[i] == expected(i));
+	}
+	rn_log("client - received %lu file bytes", received);
+	rn_socket_destroy(client);
+	free(buf);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	size_t i;
+	char *content;
+	rn_ssl_ctx_t *ssl;
+	char path[] = "/tmp/rn_ssl_sendfile.XXXXXX";
+
+	fd = mkstemp(path);
+	XTEST(fd >= 0);
+	unlink(path);
+	content = malloc(FILE_SIZE);
+	XTEST(content != NULL);
+	for (i = 0; i < FILE_SIZE; i++) {
+		content[i] = expected(i);
+	}
+	XTEST(write(fd, content, FILE_SIZE) == FILE_SIZE);
+	free(content);
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	ssl = rn_ssl_context();
+	XTEST(ssl != NULL);
+	rn_task_start(sched, server_func, ssl);
+	rn_task_start(sched, client_func, ssl);
+	rn_scheduler_loop(sched);
+	rn_ssl_context_destroy(ssl);
+	rn_scheduler_destroy(sched);
+	close(fd);
+	XPASS();
+}
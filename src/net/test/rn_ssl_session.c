@@ -0,0 +1,101 @@
+/**
+ * @file   rn_ssl_session.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for TLS session resumption.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBCONNS		6
+
+rn_sched_t *sched;
+rn_ssl_ctx_t *ctx;
+
+void process_client(void *arg)
+{
+	char b;
+	rn_socket_t *socket = arg;
+
+	XTEST(rn_socket_write(socket, "x", 1) == 1);
+	XTEST(rn_socket_read(socket, &b, 1) == 1);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *unused(arg))
+{
+	int i;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_ssl_server(sched, ctx, &addr);
+	XTEST(server != NULL);
+	for (i = 0; i < NBCONNS; i++) {
+		client = rn_socket_accept(server, &addr);
+		XTEST(client != NULL);
+		rn_task_start(sched, process_client, client);
+	}
+	rn_socket_destroy(server);
+}
+
+bool connect_once(void)
+{
+	char b;
+	bool reused;
+	rn_addr_t addr;
+	rn_socket_t *client;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_ssl_client(sched, ctx, &addr, 0);
+	XTEST(client != NULL);
+	/* Reading lets the client process session tickets */
+	XTEST(rn_socket_read(client, &b, 1) == 1);
+	XTEST(rn_socket_write(client, "y", 1) == 1);
+	reused = rn_ssl_reused(client);
+	rn_socket_destroy(client);
+	return reused;
+}
+
+void client_func(void *unused(arg))
+{
+	rn_log("client - full handshake");
+	XTEST(connect_once() == false);
+	rn_log("client - resuming with a session ticket");
+	XTEST(connect_once() == true);
+	XTEST(rn_ssl_ticket_rotate(ctx) == 0);
+	rn_log("client - resuming with a ticket from the previous key");
+	XTEST(connect_once() == true);
+	XTEST(rn_ssl_ticket_rotate(ctx) == 0);
+	XTEST(rn_ssl_ticket_rotate(ctx) == 0);
+	rn_log("client - ticket key expired");
+	XTEST(connect_once() == false);
+	SSL_CTX_set_options(ctx->ctx, SSL_OP_NO_TICKET);
+	rn_log("client - full handshake, no ticket");
+	XTEST(connect_once() == false);
+	rn_log("client - resuming from the server session cache");
+	XTEST(connect_once() == true);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	ctx = rn_ssl_context();
+	XTEST(ctx != NULL);
+	rn_task_start(sched, server_func, NULL);
+	rn_task_start(sched, client_func, NULL);
+	rn_scheduler_loop(sched);
+	rn_ssl_context_destroy(ctx);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,147 @@
+/**
+ * @file   rn_ssl_writev.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for writev on SSL sockets.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBSMALL		3
+#define NBBUFFERS	6
+
+rn_sched_t *sched;
+int records = 0;
+size_t small[NBSMALL] = { 5, 120, 1 };
+size_t sizes[NBBUFFERS] = { 10, 200, 16384, 40000, 1, 9000 };
+
+char expected(size_t i)
+{
+	return 'a' + i % 26;
+}
+
+void msg_callback(int write_p, int unused(version), int type, const void *buf, size_t unused(len), SSL *unused(ssl), void *unused(arg))
+{
+	/* Record headers written carry the record type */
+	if (write_p == 1 && type == SSL3_RT_HEADER && ((const unsigned char *) buf)[0] == SSL3_RT_APPLICATION_DATA) {
+		records++;
+	}
+}
+
+size_t send_buffers(rn_socket_t *socket, size_t *list, int count, size_t offset)
+{
+	int i;
+	size_t j;
+	size_t total;
+	rn_buffer_t *buffers[NBBUFFERS];
+
+	for (i = 0, total = offset; i < count; i++) {
+		buffers[i] = rn_buffer_create(NULL);
+		XTEST(buffers[i] != NULL);
+		for (j = 0; j < list[i]; j++, total++) {
+			XTEST(rn_buffer_add(buffers[i], (char []) { expected(total) }, 1) == 1);
+		}
+	}
+	records = 0;
+	XTEST(rn_socket_writev(socket, buffers, count) == (ssize_t) (total - offset));
+	for (i = 0; i < count; i++) {
+		rn_buffer_destroy(buffers[i]);
+	}
+	return total;
+}
+
+void process_client(void *arg)
+{
+	size_t sent;
+	size_t total;
+	rn_socket_t *socket = arg;
+
+	SSL_set_msg_callback(rn_ssl_get(socket)->ssl, msg_callback);
+	total = send_buffers(socket, small, NBSMALL, 0);
+	if (!rn_ssl_ktls(socket)) {
+		rn_log("server - small buffers sent in %d records", records);
+		XTEST(records == 1);
+	}
+	sent = send_buffers(socket, sizes, NBBUFFERS, total) - total;
+	if (!rn_ssl_ktls(socket)) {
+		/* Buffers are gathered into full records */
+		rn_log("server - %lu bytes sent in %d records", sent, records);
+		XTEST(records == (int) ((sent + RN_SSL_RECORD_SIZE - 1) / RN_SSL_RECORD_SIZE));
+	}
+	SSL_set_msg_callback(rn_ssl_get(socket)->ssl, NULL);
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *arg)
+{
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+	rn_ssl_ctx_t *ctx = arg;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_ssl_server(sched, ctx, &addr);
+	XTEST(server != NULL);
+	client = rn_socket_accept(server, &addr);
+	XTEST(client != NULL);
+	rn_task_start(sched, process_client, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *arg)
+{
+	int i;
+	char *buf;
+	size_t total;
+	size_t received;
+	ssize_t ret;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_ssl_ctx_t *ctx = arg;
+
+	for (i = 0, total = 0; i < NBSMALL; i++) {
+		total += small[i];
+	}
+	for (i = 0; i < NBBUFFERS; i++) {
+		total += sizes[i];
+	}
+	buf = malloc(total);
+	XTEST(buf != NULL);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_ssl_client(sched, ctx, &addr, 0);
+	XTEST(client != NULL);
+	for (received = 0; received < total; received += ret) {
+		ret = rn_socket_read(client, buf + received, total - received);
+		XTEST(ret > 0);
+	}
+	for (received = 0; received < total; received++) {
+		XTEST(buf[received] == expected(received));
+	}
+	rn_log("client - received %lu bytes", total);
+	rn_socket_destroy(client);
+	free(buf);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	rn_ssl_ctx_t *ssl;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	ssl = rn_ssl_context();
+	XTEST(ssl != NULL);
+	rn_task_start(sched, server_func, ssl);
+	rn_task_start(sched, client_func, ssl);
+	rn_scheduler_loop(sched);
+	rn_ssl_context_destroy(ssl);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
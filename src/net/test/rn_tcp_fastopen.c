@@ -0,0 +1,97 @@
+/**
+ * @file   rn_tcp_fastopen.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for TCP Fast Open.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBCONNECTIONS	2
+
+rn_sched_t *sched;
+
+/**
+ * Checks whether the kernel allows fast open on both client and server sides.
+ *
+ * @return true if enabled, false otherwise
+ */
+bool fastopen_enabled(void)
+{
+	int mode;
+	FILE *file;
+
+	file = fopen("/proc/sys/net/ipv4/tcp_fastopen", "r");
+	if (file == NULL) {
+		return false;
+	}
+	if (fscanf(file, "%d", &mode) != 1) {
+		mode = 0;
+	}
+	fclose(file);
+	return ((mode & 3) == 3);
+}
+
+void server_func(void *unused(arg))
+{
+	int i;
+	char buf[5];
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	/* Data in the SYN is accepted only when the server opts in */
+	XTEST(rn_socket_setopt(server, RN_SOCKET_FASTOPEN, RN_TCP_FASTOPEN_QLEN) == 0);
+	for (i = 0; i < NBCONNECTIONS; i++) {
+		client = rn_socket_accept(server, &addr);
+		XTEST(client != NULL);
+		XTEST(rn_socket_read(client, buf, 5) == 5);
+		XTEST(memcmp(buf, "hello", 5) == 0);
+		XTEST(rn_socket_write(client, "ok", 2) == 2);
+		rn_socket_destroy(client);
+	}
+	rn_socket_destroy(server);
+}
+
+void client_func(void *unused(arg))
+{
+	int i;
+	char buf[2];
+	bool fastopen;
+	rn_addr_t addr;
+	rn_socket_t *client;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	for (i = 0; i < NBCONNECTIONS; i++) {
+		client = rn_tcp_client_data(sched, &addr, 0, "hello", 5, &fastopen);
+		XTEST(client != NULL);
+		rn_log("connection %d - fast open: %s", i, (fastopen ? "yes" : "no"));
+		/* First connection only gets a cookie */
+		XTEST(fastopen == (i > 0 && fastopen_enabled()));
+		XTEST(rn_socket_read(client, buf, 2) == 2);
+		XTEST(memcmp(buf, "ok", 2) == 0);
+		rn_socket_destroy(client);
+	}
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_task_start(sched, server_func, NULL);
+	rn_task_start(sched, client_func, NULL);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,120 @@
+/**
+ * @file   rn_tcp_pool.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for the outbound TCP connection pool.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBCONNECTIONS	5
+
+rn_sched_t *sched;
+rn_tcp_pool_t *pool;
+
+void process_client(void *arg)
+{
+	char b;
+	rn_socket_t *socket = arg;
+
+	while (rn_socket_read(socket, &b, 1) == 1 && b != 'q') {
+		XTEST(rn_socket_write(socket, &b, 1) == 1);
+	}
+	rn_socket_destroy(socket);
+}
+
+void server_func(void *unused(arg))
+{
+	int i;
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	for (i = 0; i < NBCONNECTIONS; i++) {
+		client = rn_socket_accept(server, &addr);
+		XTEST(client != NULL);
+		rn_task_start(sched, process_client, client);
+	}
+	rn_socket_destroy(server);
+}
+
+void exchange(rn_socket_t *socket)
+{
+	char b;
+
+	XTEST(rn_socket_write(socket, "x", 1) == 1);
+	XTEST(rn_socket_read(socket, &b, 1) == 1);
+	XTEST(b == 'x');
+}
+
+void client_func(void *unused(arg))
+{
+	rn_addr_t addr;
+	rn_socket_t *a;
+	rn_socket_t *b;
+	rn_socket_t *c;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	a = rn_tcp_pool_get(pool, &addr, 0);
+	XTEST(a != NULL);
+	exchange(a);
+	rn_tcp_pool_release(pool, a, &addr, true);
+	rn_log("warm connection is reused");
+	b = rn_tcp_pool_get(pool, &addr, 0);
+	XTEST(b == a);
+	exchange(b);
+	XTEST(pool->hits == 1 && pool->misses == 1);
+	rn_log("max total is enforced");
+	b = rn_tcp_pool_get(pool, &addr, 0);
+	XTEST(b != NULL && b != a);
+	c = rn_tcp_pool_get(pool, &addr, 0);
+	XTEST(c != NULL);
+	XTEST(rn_tcp_pool_get(pool, &addr, 0) == NULL);
+	XTEST(rn_error == EBUSY);
+	rn_log("max idle is enforced");
+	rn_tcp_pool_release(pool, a, &addr, true);
+	rn_tcp_pool_release(pool, b, &addr, true);
+	rn_tcp_pool_release(pool, c, &addr, true);
+	XTEST(rn_list_size(&pool->lru) == 2);
+	rn_log("idle connections are reaped");
+	rn_task_wait(sched, 100);
+	XTEST(rn_list_size(&pool->lru) == 0);
+	rn_log("closed connections are not reused");
+	a = rn_tcp_pool_get(pool, &addr, 0);
+	XTEST(a != NULL);
+	XTEST(pool->misses == 4);
+	XTEST(rn_socket_write(a, "q", 1) == 1);
+	rn_tcp_pool_release(pool, a, &addr, true);
+	rn_task_wait(sched, 10);
+	a = rn_tcp_pool_get(pool, &addr, 0);
+	XTEST(a != NULL);
+	XTEST(pool->misses == 5);
+	exchange(a);
+	rn_tcp_pool_release(pool, a, &addr, false);
+	XTEST(rn_list_size(&pool->lru) == 0);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	pool = rn_tcp_pool(sched, 2, 3, 50);
+	XTEST(pool != NULL);
+	rn_task_start(sched, server_func, NULL);
+	rn_task_start(sched, client_func, NULL);
+	rn_scheduler_loop(sched);
+	rn_tcp_pool_destroy(pool);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,117 @@
+/**
+ * @file   rn_tcp_zerocopy.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for zero-copy TCP sends.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBBUFFERS	4
+#define BUFFER_SIZE	(1024 * 1024)
+#define SMALL_SIZE	100
+#define TOTAL_SIZE	(NBBUFFERS * BUFFER_SIZE + SMALL_SIZE)
+
+rn_buffer_t *pattern(size_t size)
+{
+	size_t i;
+	rn_buffer_t *buffer;
+
+	buffer = rn_buffer_create(NULL);
+	XTEST(buffer != NULL);
+	XTEST(rn_buffer_extend(buffer, size) == 0);
+	for (i = 0; i < size; i++) {
+		((char *) rn_buffer_ptr(buffer))[i] = 'a' + i % 26;
+	}
+	rn_buffer_setsize(buffer, size);
+	return buffer;
+}
+
+void process_client(void *arg)
+{
+	char *buf;
+	size_t i;
+	size_t received;
+	ssize_t ret;
+	rn_socket_t *client = arg;
+
+	buf = malloc(TOTAL_SIZE);
+	XTEST(buf != NULL);
+	received = 0;
+	while (received < TOTAL_SIZE) {
+		ret = rn_socket_read(client, buf + received, TOTAL_SIZE - received);
+		XTEST(ret > 0);
+		received += ret;
+	}
+	for (i = 0; i < NBBUFFERS * BUFFER_SIZE; i++) {
+		XTEST(buf[i] == 'a' + (char) ((i % BUFFER_SIZE) % 26));
+	}
+	for (i = 0; i < SMALL_SIZE; i++) {
+		XTEST(buf[NBBUFFERS * BUFFER_SIZE + i] == 'a' + (char) (i % 26));
+	}
+	rn_log("server - received %lu bytes", received);
+	free(buf);
+	rn_socket_destroy(client);
+}
+
+void server_func(void *arg)
+{
+	rn_addr_t from;
+	rn_socket_t *client;
+	rn_socket_t *server = arg;
+
+	client = rn_socket_accept(server, &from);
+	XTEST(client != NULL);
+	rn_log("server - accepting client");
+	rn_task_start(server->node.sched, process_client, client);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *sched)
+{
+	int i;
+	rn_addr_t addr;
+	rn_socket_t *socket;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	socket = rn_tcp_client(sched, &addr, 0);
+	XTEST(socket != NULL);
+	XTEST(rn_tcp_zerocopy(socket) == 0);
+	for (i = 0; i < NBBUFFERS; i++) {
+		XTEST(rn_tcp_sendzc(socket, pattern(BUFFER_SIZE)) == BUFFER_SIZE);
+	}
+	/* Below threshold, copied and released right away */
+	XTEST(rn_tcp_sendzc(socket, pattern(SMALL_SIZE)) == SMALL_SIZE);
+	XTEST(rn_tcp_zcflush(socket) == 0);
+	XTEST(socket->zerocopy->sent > 0);
+	XTEST(socket->zerocopy->completed == socket->zerocopy->sent);
+	XTEST(rn_list_size(&socket->zerocopy->pending) == 0);
+	rn_log("client - %u zero-copy sends, %lu copied by the kernel", socket->zerocopy->sent, socket->zerocopy->copied);
+	rn_socket_destroy(socket);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	rn_addr_t addr;
+	rn_sched_t *sched;
+	rn_socket_t *server;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	XTEST(rn_task_start(sched, server_func, server) == 0);
+	XTEST(rn_task_start(sched, client_func, sched) == 0);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file   rn_udp_gso.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for UDP segmentation and receive offload.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBSEGS		10
+#define SEGSIZE		1000
+
+void server_func(void *arg)
+{
+	size_t i;
+	ssize_t ret;
+	size_t total;
+	char *buf;
+	uint16_t segsize;
+	rn_addr_t from;
+	rn_socket_t *server = arg;
+
+	buf = malloc(RN_UDP_GSO_MAX_SIZE);
+	XTEST(buf != NULL);
+	if (rn_udp_gro(server, true) != 0) {
+		rn_log("server - GRO not supported");
+	}
+	total = 0;
+	while (total < NBSEGS * SEGSIZE) {
+		ret = rn_udp_recvgro(server, buf, RN_UDP_GSO_MAX_SIZE, &from, &segsize);
+		XTEST(ret > 0);
+		XTEST(segsize == SEGSIZE);
+		rn_log("server - received %ld bytes in %ld segments", ret, (ret + segsize - 1) / segsize);
+		for (i = 0; i < (size_t) ret; i++) {
+			/* Each segment is filled with its index */
+			XTEST(buf[i] == (char) ((total + i) / SEGSIZE));
+		}
+		total += ret;
+	}
+	XTEST(total == NBSEGS * SEGSIZE);
+	free(buf);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *sched)
+{
+	int i;
+	char *buf;
+	rn_addr_t addr;
+	rn_socket_t *socket;
+
+	buf = malloc(NBSEGS * SEGSIZE);
+	XTEST(buf != NULL);
+	for (i = 0; i < NBSEGS; i++) {
+		memset(buf + i * SEGSIZE, i, SEGSIZE);
+	}
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	socket = rn_udp_client(sched, &addr);
+	XTEST(socket != NULL);
+	XTEST(rn_udp_sendgso(socket, buf, NBSEGS * SEGSIZE, SEGSIZE, NULL) == NBSEGS * SEGSIZE);
+	free(buf);
+	rn_socket_destroy(socket);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	bool stats;
+	rn_addr_t addr;
+	rn_sched_t *sched;
+	rn_socket_t *server;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	/* Offloaded sends and receives are accounted too (unless built with RINOO_NO_STATS) */
+	stats = (rn_scheduler_stats_enable(sched, true) == 0);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_udp_server(sched, &addr);
+	XTEST(server != NULL);
+	XTEST(rn_task_start(sched, server_func, server) == 0);
+	XTEST(rn_task_start(sched, client_func, sched) == 0);
+	rn_scheduler_loop(sched);
+	if (stats) {
+		XTEST(rn_scheduler_stats(sched)->bytes_out == NBSEGS * SEGSIZE);
+		XTEST(rn_scheduler_stats(sched)->bytes_in == NBSEGS * SEGSIZE);
+	}
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,78 @@
+/**
+ * @file   rn_udp_serve.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for rn_udp_serve.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBSPAWNS	3
+#define NBCLIENTS	16
+
+int nbdone = 0;
+int checker[NBSPAWNS + 1];
+
+void handler_func(rn_socket_t *socket, rn_msg_t *msg, void *arg)
+{
+	int id;
+
+	XTEST(arg == checker);
+	XTEST(msg->len == 4);
+	XTEST(memcmp(msg->buf, "ping", 4) == 0);
+	id = rn_scheduler_self()->id;
+	__atomic_add_fetch(&checker[id], 1, __ATOMIC_RELAXED);
+	XTEST(rn_socket_sendto(socket, &id, sizeof(id), &msg->addr) == sizeof(id));
+}
+
+void client_func(void *sched)
+{
+	int id;
+	rn_addr_t addr;
+	rn_socket_t *socket;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	socket = rn_udp_client(sched, &addr);
+	XTEST(socket != NULL);
+	XTEST(rn_socket_write(socket, "ping", 4) == 4);
+	XTEST(rn_socket_read(socket, &id, sizeof(id)) == sizeof(id));
+	XTEST(id >= 0 && id <= NBSPAWNS);
+	rn_socket_destroy(socket);
+	if (++nbdone == NBCLIENTS) {
+		rn_scheduler_stop(sched);
+	}
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	int i;
+	int total;
+	rn_addr_t addr;
+	rn_sched_t *sched;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	XTEST(rn_spawn(sched, NBSPAWNS) == 0);
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	XTEST(rn_udp_serve(sched, &addr, handler_func, checker) == 0);
+	for (i = 0; i < NBCLIENTS; i++) {
+		XTEST(rn_task_start(sched, client_func, sched) == 0);
+	}
+	rn_scheduler_loop(sched);
+	XTEST(nbdone == NBCLIENTS);
+	for (i = 0, total = 0; i <= NBSPAWNS; i++) {
+		rn_log("scheduler %d: %d datagrams", i, checker[i]);
+		total += checker[i];
+	}
+	XTEST(total == NBCLIENTS);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,114 @@
+/**
+ * @file   rn_unix.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for unix domain sockets.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define STREAM_PATH	"@rinoo_test_unix"
+#define DGRAM_PATH	"/tmp/rinoo_test_unix.sock"
+
+rn_sched_t *sched;
+
+void stream_server(void *unused(arg))
+{
+	char b[6];
+	rn_addr_t addr;
+	rn_socket_t *client;
+	rn_socket_t *server;
+
+	XTEST(rn_addr_un(&addr, STREAM_PATH) == 0);
+	server = rn_unix_server(sched, &addr, SOCK_STREAM);
+	XTEST(server != NULL);
+	client = rn_socket_accept(server, &addr);
+	XTEST(client != NULL);
+	XTEST(rn_socket_read(client, b, 6) == 6);
+	XTEST(memcmp(b, "hello\n", 6) == 0);
+	XTEST(rn_socket_write(client, "world\n", 6) == 6);
+	rn_socket_destroy(client);
+	rn_socket_destroy(server);
+}
+
+void stream_client(void *unused(arg))
+{
+	char b[6];
+	rn_addr_t addr;
+	rn_socket_t *client;
+
+	XTEST(rn_addr_un(&addr, STREAM_PATH) == 0);
+	client = rn_unix_client(sched, &addr, SOCK_STREAM, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_write(client, "hello\n", 6) == 6);
+	XTEST(rn_socket_read(client, b, 6) == 6);
+	XTEST(memcmp(b, "world\n", 6) == 0);
+	XTEST(rn_socket_read(client, b, 6) == -1);
+	rn_socket_destroy(client);
+}
+
+void dgram_server(void *unused(arg))
+{
+	char b[6];
+	rn_addr_t addr;
+	rn_addr_t from;
+	rn_socket_t *server;
+
+	XTEST(rn_addr_un(&addr, DGRAM_PATH) == 0);
+	server = rn_unix_server(sched, &addr, SOCK_DGRAM);
+	XTEST(server != NULL);
+	/* A live server keeps its path */
+	XTEST(rn_unix_server(sched, &addr, SOCK_DGRAM) == NULL);
+	XTEST(rn_error == EADDRINUSE);
+	XTEST(rn_socket_recvfrom(server, b, sizeof(b), &from) == 4);
+	XTEST(memcmp(b, "ping", 4) == 0);
+	XTEST(IS_UNIX(&from));
+	XTEST(rn_socket_sendto(server, "pong", 4, &from) == 4);
+	rn_socket_destroy(server);
+	/* The socket file left over is replaced */
+	server = rn_unix_server(sched, &addr, SOCK_DGRAM);
+	XTEST(server != NULL);
+	rn_socket_destroy(server);
+	unlink(DGRAM_PATH);
+}
+
+void dgram_client(void *unused(arg))
+{
+	char b[6];
+	rn_addr_t addr;
+	rn_socket_t *client;
+
+	XTEST(rn_addr_un(&addr, DGRAM_PATH) == 0);
+	client = rn_unix_client(sched, &addr, SOCK_DGRAM, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_write(client, "ping", 4) == 4);
+	XTEST(rn_socket_read(client, b, sizeof(b)) == 4);
+	XTEST(memcmp(b, "pong", 4) == 0);
+	rn_socket_destroy(client);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	char path[200];
+
+	memset(path, 'a', sizeof(path) - 1);
+	path[sizeof(path) - 1] = '\0';
+	XTEST(rn_addr_un(&(rn_addr_t){ 0 }, path) == -1);
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_task_start(sched, stream_server, NULL);
+	rn_task_start(sched, stream_client, NULL);
+	rn_task_start(sched, dgram_server, NULL);
+	rn_task_start(sched, dgram_client, NULL);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -0,0 +1,113 @@
+/**
+ * @file   rn_unix_fdpass.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Test file for file descriptor passing over unix sockets.
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define UNIX_PATH	"@rinoo_test_fdpass"
+#define NBCLIENTS	3
+
+extern const rn_socket_class_t socket_class_tcp;
+
+rn_sched_t *sched;
+
+/* Accepts TCP connections and passes them to the worker in one message */
+void acceptor_func(void *unused(arg))
+{
+	int i;
+	int fds[NBCLIENTS];
+	rn_addr_t addr;
+	rn_socket_t *link;
+	rn_socket_t *server;
+	rn_socket_t *clients[NBCLIENTS];
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	server = rn_tcp_server(sched, &addr);
+	XTEST(server != NULL);
+	for (i = 0; i < NBCLIENTS; i++) {
+		clients[i] = rn_socket_accept(server, &addr);
+		XTEST(clients[i] != NULL);
+		fds[i] = clients[i]->node.fd;
+	}
+	rn_socket_destroy(server);
+	XTEST(rn_addr_un(&addr, UNIX_PATH) == 0);
+	link = rn_unix_client(sched, &addr, SOCK_STREAM, 0);
+	XTEST(link != NULL);
+	XTEST(rn_socket_sendfd(link, fds, NBCLIENTS) == NBCLIENTS);
+	/* Sent again, to a receiver with too little room */
+	XTEST(rn_socket_sendfd(link, fds, NBCLIENTS) == NBCLIENTS);
+	for (i = 0; i < NBCLIENTS; i++) {
+		rn_socket_destroy(clients[i]);
+	}
+	rn_socket_destroy(link);
+}
+
+/* Receives connections and serves them */
+void worker_func(void *unused(arg))
+{
+	int i;
+	rn_addr_t addr;
+	rn_socket_t *link;
+	rn_socket_t *server;
+	rn_socket_t *sockets[RN_UNIX_MAXFDS];
+
+	XTEST(rn_addr_un(&addr, UNIX_PATH) == 0);
+	server = rn_unix_server(sched, &addr, SOCK_STREAM);
+	XTEST(server != NULL);
+	link = rn_socket_accept(server, &addr);
+	XTEST(link != NULL);
+	XTEST(rn_socket_recvfd(link, sockets, RN_UNIX_MAXFDS) == NBCLIENTS);
+	for (i = 0; i < NBCLIENTS; i++) {
+		XTEST(sockets[i]->class == &socket_class_tcp);
+		XTEST(sockets[i]->node.sched == sched);
+		XTEST(rn_socket_write(sockets[i], "hello\n", 6) == 6);
+		rn_socket_destroy(sockets[i]);
+	}
+	XTEST(rn_socket_recvfd(link, sockets, NBCLIENTS - 1) == -1);
+	XTEST(rn_error == EMSGSIZE);
+	XTEST(rn_socket_recvfd(link, sockets, RN_UNIX_MAXFDS) == -1);
+	XTEST(rn_error == ECONNRESET);
+	rn_socket_destroy(link);
+	rn_socket_destroy(server);
+}
+
+void client_func(void *unused(arg))
+{
+	char b[6];
+	rn_addr_t addr;
+	rn_socket_t *client;
+
+	rn_addr4(&addr, "127.0.0.1", 4242);
+	client = rn_tcp_client(sched, &addr, 0);
+	XTEST(client != NULL);
+	XTEST(rn_socket_read(client, b, 6) == 6);
+	XTEST(memcmp(b, "hello\n", 6) == 0);
+	rn_socket_destroy(client);
+}
+
+/**
+ * Main function for this unit test.
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	int i;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_task_start(sched, worker_func, NULL);
+	rn_task_start(sched, acceptor_func, NULL);
+	for (i = 0; i < NBCLIENTS; i++) {
+		rn_task_start(sched, client_func, NULL);
+	}
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
@@ -27,3 +27,343 @@ rn_socket_t *rn_udp_client(rn_sched_t *sched, rn_addr_t *dst)
 	}
 	return socket;
 }
+
+/**
+ * Creates a UDP server bound to a specific address.
+ *
+ * @param sched Scheduler pointer
+ * @param dst Address to bind
+ *
+ * @return Socket pointer to the server on success or NULL if an error occurs
+ */
+rn_socket_t *rn_udp_server(rn_sched_t *sched, rn_addr_t *dst)
+{
+	rn_socket_t *socket;
+
+	socket = rn_socket(sched, (IS_IPV6(dst) ? &socket_class_udp6 : &socket_class_udp));
+	if (unlikely(socket == NULL)) {
+		return NULL;
+	}
+	if (rn_socket_bind(socket, dst, 0) != 0) {
+		rn_socket_destroy(socket);
+		return NULL;
+	}
+	return socket;
+}
+
+/**
+ * Receive loop of a UDP service, run as a task on each scheduler.
+ *
+ * @param arg Pointer to the UDP service context
+ */
+static void rn_udp_serve_loop(void *arg)
+{
+	int i;
+	int nbmsgs;
+	rn_udp_serve_t *serve = arg;
+
+	for (i = 0; i < RN_MMSG_MAX; i++) {
+		serve->msgs[i].buf = serve->bufs[i];
+		serve->msgs[i].size = sizeof(serve->bufs[i]);
+	}
+	while ((nbmsgs = rn_socket_recvmmsg(serve->socket, serve->msgs, RN_MMSG_MAX)) > 0) {
+		for (i = 0; i < nbmsgs; i++) {
+			serve->handler(serve->socket, &serve->msgs[i], serve->arg);
+		}
+	}
+	rn_socket_destroy(serve->socket);
+	free(serve);
+}
+
+/**
+ * Serves UDP datagrams on a scheduler and all its spawns.
+ * Each scheduler gets its own socket bound with SO_REUSEPORT, so that
+ * the kernel spreads datagrams across threads, and a task which calls
+ * handler for every datagram received. Datagrams larger than
+ * RN_UDP_MSG_SIZE are truncated.
+ * This must be called after rn_spawn and before running the scheduler loop.
+ * On error, sockets and tasks already set up on other schedulers are removed.
+ *
+ * @param sched Pointer to the main scheduler
+ * @param dst Address to bind
+ * @param handler Function called for each datagram, msg->addr is its source
+ * @param arg Argument passed to handler
+ *
+ * @return 0 on success, or -1 if an error occurs
+ */
+int rn_udp_serve(rn_sched_t *sched, rn_addr_t *dst, void (*handler)(rn_socket_t *socket, rn_msg_t *msg, void *arg), void *arg)
+{
+	int i;
+	rn_list_t serves;
+	rn_sched_t *cur;
+	rn_list_node_t *node;
+	rn_udp_serve_t *serve;
+
+	XASSERT(sched != NULL, -1);
+	XASSERT(handler != NULL, -1);
+
+	rn_list(&serves, NULL);
+	for (i = 0; i <= sched->spawns.count; i++) {
+		cur = rn_spawn_get(sched, i);
+		if (cur == NULL) {
+			goto error;
+		}
+		serve = malloc(sizeof(*serve));
+		if (unlikely(serve == NULL)) {
+			rn_error_set(errno);
+			goto error;
+		}
+		serve->arg = arg;
+		serve->handler = handler;
+		serve->socket = rn_udp_server(cur, dst);
+		if (serve->socket == NULL) {
+			free(serve);
+			goto error;
+		}
+		serve->task = rn_task(cur, &cur->driver.main, rn_udp_serve_loop, serve);
+		if (serve->task == NULL) {
+			rn_socket_destroy(serve->socket);
+			free(serve);
+			goto error;
+		}
+		rn_list_put(&serves, &serve->lnode);
+	}
+	/* Every scheduler is set up, loops can be started */
+	while ((node = rn_list_pop(&serves)) != NULL) {
+		serve = container_of(node, rn_udp_serve_t, lnode);
+		rn_task_schedule(serve->task, NULL);
+	}
+	return 0;
+error:
+	/* Scheduler loops are not running yet, tasks can be dropped */
+	while ((node = rn_list_pop(&serves)) != NULL) {
+		serve = container_of(node, rn_udp_serve_t, lnode);
+		rn_task_destroy(serve->task);
+		rn_socket_destroy(serve->socket);
+		free(serve);
+	}
+	return -1;
+}
+
+/**
+ * Sends a buffer as a list of datagrams, without segmentation offload.
+ *
+ * @param socket Pointer to the socket to use
+ * @param buf Buffer to send
+ * @param count Buffer size
+ * @param segsize Size of each datagram
+ * @param dst Destination address, or NULL if the socket is connected
+ *
+ * @return The number of bytes sent on success or -1 if an error occurs
+ */
+static ssize_t rn_udp_sendsegments(rn_socket_t *socket, const void *buf, size_t count, uint16_t segsize, const rn_addr_t *dst)
+{
+	int i;
+	int ret;
+	size_t sent;
+	rn_msg_t msgs[RN_MMSG_MAX];
+
+	sent = 0;
+	while (sent < count) {
+		for (i = 0; i < RN_MMSG_MAX && sent < count; i++) {
+			msgs[i].buf = (char *) buf + sent;
+			msgs[i].len = (count - sent < segsize ? count - sent : segsize);
+			if (dst != NULL) {
+				msgs[i].addr = *dst;
+			} else {
+				msgs[i].addr.sa.sa_family = AF_UNSPEC;
+			}
+			sent += msgs[i].len;
+		}
+		ret = rn_socket_sendmmsg(socket, msgs, i);
+		if (ret != i) {
+			return -1;
+		}
+	}
+	return sent;
+}
+
+/**
+ * Checks once per socket whether the kernel supports UDP_SEGMENT.
+ * Kernels without it reject the socket option with ENOPROTOOPT, whereas an
+ * invalid segment size is only reported by sendmsg (EINVAL).
+ *
+ * @param socket Pointer to the socket to check
+ *
+ * @return true if segmentation offload can be used, false otherwise
+ */
+static bool rn_udp_gso_supported(rn_socket_t *socket)
+{
+	int value = 0;
+
+	if ((socket->flags & RN_SOCKET_FLAG_GSOPROBED) == 0) {
+		socket->flags |= RN_SOCKET_FLAG_GSOPROBED;
+		if (setsockopt(socket->node.fd, SOL_UDP, UDP_SEGMENT, &value, sizeof(value)) != 0) {
+			socket->flags |= RN_SOCKET_FLAG_NOGSO;
+		}
+	}
+	return ((socket->flags & RN_SOCKET_FLAG_NOGSO) == 0);
+}
+
+/**
+ * Sends a buffer as datagrams of segsize bytes (the last one can be shorter),
+ * letting the kernel split it with UDP generic segmentation offload.
+ * If the kernel does not support UDP_SEGMENT, datagrams are sent in batches
+ * with sendmmsg instead. Segment sizes the kernel rejects (like above the
+ * path MTU) fail with EINVAL.
+ *
+ * @param socket Pointer to the socket to use
+ * @param buf Buffer to send
+ * @param count Buffer size
+ * @param segsize Size of each datagram
+ * @param dst Destination address, or NULL if the socket is connected
+ *
+ * @return The number of bytes sent on success or -1 if an error occurs
+ */
+ssize_t rn_udp_sendgso(rn_socket_t *socket, const void *buf, size_t count, uint16_t segsize, const rn_addr_t *dst)
+{
+	size_t len;
+	size_t max;
+	size_t sent;
+	ssize_t ret;
+	struct iovec iov;
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	char control[CMSG_SPACE(sizeof(uint16_t))];
+
+	XASSERT(socket != NULL, -1);
+	XASSERT(segsize > 0, -1);
+
+	if (count <= segsize || !rn_udp_gso_supported(socket)) {
+		return rn_udp_sendsegments(socket, buf, count, segsize, dst);
+	}
+	max = RN_UDP_GSO_MAX_SIZE / segsize;
+	if (max > RN_UDP_GSO_MAX_SEGMENTS) {
+		max = RN_UDP_GSO_MAX_SEGMENTS;
+	}
+	max *= segsize;
+	if (rn_socket_waitio(socket) != 0) {
+		return -1;
+	}
+	sent = 0;
+	while (sent < count) {
+		len = (count - sent < max ? count - sent : max);
+		iov.iov_base = (char *) buf + sent;
+		iov.iov_len = len;
+		memset(&msg, 0, sizeof(msg));
+		if (dst != NULL) {
+			msg.msg_name = (void *) dst;
+			msg.msg_namelen = rn_addr_len(dst);
+		}
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_UDP;
+		cmsg->cmsg_type = UDP_SEGMENT;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		memcpy(CMSG_DATA(cmsg), &segsize, sizeof(segsize));
+		if (rn_socket_throttle(socket, len) < 0) {
+			return -1;
+		}
+		ret = rn_socket_throttled(socket, rn_socket_stat_out(socket, sendmsg(socket->node.fd, &msg, MSG_DONTWAIT)));
+		if (ret < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				if (rn_socket_waitout(socket) != 0) {
+					return -1;
+				}
+				continue;
+			}
+			rn_error_set(errno);
+			return -1;
+		}
+		sent += ret;
+	}
+	return sent;
+}
+
+/**
+ * Enables or disables UDP generic receive offload on a socket.
+ * When enabled, the kernel can coalesce datagrams of a same flow,
+ * which must then be read with rn_udp_recvgro.
+ *
+ * @param socket Pointer to the socket to use
+ * @param enabled Whether GRO should be enabled
+ *
+ * @return 0 on success, or -1 if an error occurs (kernel does not support it)
+ */
+int rn_udp_gro(rn_socket_t *socket, bool enabled)
+{
+	int value;
+
+	XASSERT(socket != NULL, -1);
+
+	value = (enabled ? 1 : 0);
+	if (setsockopt(socket->node.fd, SOL_UDP, UDP_GRO, &value, sizeof(value)) != 0) {
+		rn_error_set(errno);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Receives datagrams, possibly coalesced by UDP generic receive offload.
+ * segsize is set to the size of each coalesced datagram: received data
+ * must be split every segsize bytes, the last datagram can be shorter.
+ * Without GRO, segsize is the size of the single datagram received.
+ * buf should be RN_UDP_GSO_MAX_SIZE bytes long to avoid truncation.
+ *
+ * @param socket Pointer to the socket to read
+ * @param buf Buffer where to store the data read
+ * @param count Buffer size
+ * @param from Pointer where to store the source address, can be NULL
+ * @param segsize Pointer where to store the datagram size
+ *
+ * @return The number of bytes read on success or -1 if an error occurs
+ */
+ssize_t rn_udp_recvgro(rn_socket_t *socket, void *buf, size_t count, rn_addr_t *from, uint16_t *segsize)
+{
+	int value;
+	ssize_t ret;
+	struct iovec iov;
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	char control[CMSG_SPACE(sizeof(int))];
+
+	XASSERT(socket != NULL, -1);
+	XASSERT(segsize != NULL, -1);
+
+	if (rn_socket_waitio(socket) != 0) {
+		return -1;
+	}
+	iov.iov_base = buf;
+	iov.iov_len = count;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	msg.msg_name = from;
+	msg.msg_namelen = (from != NULL ? sizeof(*from) : 0);
+	while ((ret = rn_socket_stat_in(socket, recvmsg(socket->node.fd, &msg, MSG_DONTWAIT))) < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			rn_error_set(errno);
+			return -1;
+		}
+		if (rn_socket_waitin(socket) != 0) {
+			return -1;
+		}
+		msg.msg_controllen = sizeof(control);
+		msg.msg_namelen = (from != NULL ? sizeof(*from) : 0);
+	}
+	*segsize = ret;
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+			memcpy(&value, CMSG_DATA(cmsg), sizeof(value));
+			*segsize = value;
+			break;
+		}
+	}
+	return ret;
+}
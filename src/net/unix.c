@@ -0,0 +1,294 @@
+/**
+ * @file   unix.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Unix domain socket management
+ *
+ *
+ */
+
+#include "rinoo/net/module.h"
+
+extern const rn_socket_class_t socket_class_tcp;
+extern const rn_socket_class_t socket_class_tcp6;
+extern const rn_socket_class_t socket_class_udp;
+extern const rn_socket_class_t socket_class_udp6;
+extern const rn_socket_class_t socket_class_unix;
+extern const rn_socket_class_t socket_class_unixdgram;
+
+static const rn_socket_class_t *rn_unix_classes[] = {
+	&socket_class_tcp,
+	&socket_class_tcp6,
+	&socket_class_udp,
+	&socket_class_udp6,
+	&socket_class_unix,
+	&socket_class_unixdgram
+};
+
+/**
+ * Creates a unix socket client connected to a specific address.
+ * Datagram clients are bound to an automatic abstract name first,
+ * so that servers can reply to the source address of their requests.
+ *
+ * @param sched Scheduler pointer
+ * @param dst Destination address to connect to (see rn_addr_un)
+ * @param type SOCK_STREAM or SOCK_DGRAM
+ * @param timeout Socket timeout
+ *
+ * @return Socket pointer on success or NULL if an error occurs
+ */
+rn_socket_t *rn_unix_client(rn_sched_t *sched, rn_addr_t *dst, int type, uint32_t timeout)
+{
+	rn_socket_t *socket;
+	sa_family_t family;
+
+	XASSERT(type == SOCK_STREAM || type == SOCK_DGRAM, NULL);
+
+	socket = rn_socket(sched, (type == SOCK_STREAM ? &socket_class_unix : &socket_class_unixdgram));
+	if (unlikely(socket == NULL)) {
+		return NULL;
+	}
+	if (timeout != 0 && rn_socket_timeout(socket, timeout) != 0) {
+		rn_socket_destroy(socket);
+		return NULL;
+	}
+	if (type == SOCK_DGRAM) {
+		family = AF_UNIX;
+		if (bind(socket->node.fd, (struct sockaddr *) &family, sizeof(family)) != 0) {
+			rn_error_set(errno);
+			rn_socket_destroy(socket);
+			return NULL;
+		}
+	}
+	if (rn_socket_connect(socket, dst) != 0) {
+		rn_socket_destroy(socket);
+		return NULL;
+	}
+	return socket;
+}
+
+/**
+ * Creates a unix socket server bound to a specific address.
+ * Stream servers listen to new connections, datagram servers
+ * receive requests with rn_socket_recvfrom or rn_socket_recvmmsg.
+ *
+ * @param sched Scheduler pointer
+ * @param dst Address to bind (see rn_addr_un)
+ * @param type SOCK_STREAM or SOCK_DGRAM
+ *
+ * @return Socket pointer to the server on success or NULL if an error occurs
+ */
+rn_socket_t *rn_unix_server(rn_sched_t *sched, rn_addr_t *dst, int type)
+{
+	rn_socket_t *socket;
+
+	XASSERT(type == SOCK_STREAM || type == SOCK_DGRAM, NULL);
+
+	socket = rn_socket(sched, (type == SOCK_STREAM ? &socket_class_unix : &socket_class_unixdgram));
+	if (unlikely(socket == NULL)) {
+		return NULL;
+	}
+	if (rn_socket_bind(socket, dst, RN_UNIX_BACKLOG) != 0) {
+		rn_socket_destroy(socket);
+		return NULL;
+	}
+	return socket;
+}
+
+/**
+ * Sends file descriptors to the peer of a unix socket (SCM_RIGHTS).
+ * Descriptors are sent by batches of RN_UNIX_MAXFDS per message, the
+ * peer gets its own copies: the sender can close them once sent.
+ *
+ * @param socket Pointer to a connected unix socket
+ * @param fds Array of file descriptors to send
+ * @param count Number of file descriptors
+ *
+ * @return count on success or -1 if an error occurs
+ */
+int rn_socket_sendfd(rn_socket_t *socket, const int *fds, int count)
+{
+	int len;
+	int sent;
+	ssize_t ret;
+	struct iovec iov;
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	char control[CMSG_SPACE(sizeof(int) * RN_UNIX_MAXFDS)];
+
+	XASSERT(socket != NULL, -1);
+	XASSERT(fds != NULL, -1);
+	XASSERT(count > 0, -1);
+
+	if (rn_socket_waitio(socket) != 0) {
+		return -1;
+	}
+	sent = 0;
+	while (sent < count) {
+		len = (count - sent < RN_UNIX_MAXFDS ? count - sent : RN_UNIX_MAXFDS);
+		/* Stream sockets cannot carry ancillary data alone */
+		iov.iov_base = "";
+		iov.iov_len = 1;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = CMSG_SPACE(sizeof(int) * len);
+		cmsg = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type = SCM_RIGHTS;
+		cmsg->cmsg_len = CMSG_LEN(sizeof(int) * len);
+		memcpy(CMSG_DATA(cmsg), fds + sent, sizeof(int) * len);
+		ret = rn_socket_stat_out(socket, sendmsg(socket->node.fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL));
+		if (ret < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				rn_error_set(errno);
+				return -1;
+			}
+			if (rn_socket_waitout(socket) != 0) {
+				return -1;
+			}
+			continue;
+		}
+		sent += len;
+	}
+	return count;
+}
+
+/**
+ * Wraps a received file descriptor into a socket of the matching class.
+ *
+ * @param sched Scheduler of the new socket
+ * @param fd File descriptor
+ *
+ * @return Socket pointer on success or NULL if fd is not a socket of a known class
+ */
+static rn_socket_t *rn_unix_wrapfd(rn_sched_t *sched, int fd)
+{
+	size_t i;
+	int type;
+	int domain;
+	int enabled;
+	socklen_t size;
+	rn_socket_t *socket;
+	const rn_socket_class_t *class;
+
+	size = sizeof(domain);
+	if (getsockopt(fd, SOL_SOCKET, SO_DOMAIN, &domain, &size) != 0) {
+		return NULL;
+	}
+	size = sizeof(type);
+	if (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &size) != 0) {
+		return NULL;
+	}
+	class = NULL;
+	for (i = 0; i < sizeof(rn_unix_classes) / sizeof(*rn_unix_classes); i++) {
+		if (rn_unix_classes[i]->domain == domain && rn_unix_classes[i]->type == type) {
+			class = rn_unix_classes[i];
+			break;
+		}
+	}
+	if (class == NULL) {
+		return NULL;
+	}
+	enabled = 1;
+	if (ioctl(fd, FIONBIO, &enabled) != 0) {
+		return NULL;
+	}
+	socket = class->create(sched);
+	if (unlikely(socket == NULL)) {
+		return NULL;
+	}
+	socket->class = class;
+	socket->node.fd = fd;
+	return socket;
+}
+
+/**
+ * Receives file descriptors sent with rn_socket_sendfd.
+ * At most one message is read, carrying up to RN_UNIX_MAXFDS descriptors.
+ * Each descriptor is wrapped into a socket of its class (TCP, UDP or unix)
+ * attached to the scheduler of the unix socket. Descriptors which are not
+ * sockets of a known class are closed.
+ *
+ * @param socket Pointer to a connected unix socket
+ * @param sockets Array where to store received sockets
+ * @param count Array size
+ *
+ * @return The number of sockets received on success or -1 if an error occurs
+ * (EMSGSIZE if the message carried more than count descriptors, which are then all closed,
+ * ECONNRESET if the peer closed the connection)
+ */
+int rn_socket_recvfd(rn_socket_t *socket, rn_socket_t **sockets, int count)
+{
+	int i;
+	int len;
+	int nbfds;
+	int received;
+	int fds[RN_UNIX_MAXFDS];
+	char byte;
+	ssize_t ret;
+	struct iovec iov;
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	char control[CMSG_SPACE(sizeof(int) * RN_UNIX_MAXFDS)];
+
+	XASSERT(socket != NULL, -1);
+	XASSERT(sockets != NULL, -1);
+	XASSERT(count > 0, -1);
+
+	if (rn_socket_waitio(socket) != 0) {
+		return -1;
+	}
+	iov.iov_base = &byte;
+	iov.iov_len = 1;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	while ((ret = rn_socket_stat_in(socket, recvmsg(socket->node.fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC))) < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			rn_error_set(errno);
+			return -1;
+		}
+		if (rn_socket_waitin(socket) != 0) {
+			return -1;
+		}
+		msg.msg_controllen = sizeof(control);
+	}
+	if (ret == 0) {
+		rn_error_set(ECONNRESET);
+		return -1;
+	}
+	nbfds = 0;
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+			continue;
+		}
+		len = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		if (len > RN_UNIX_MAXFDS - nbfds) {
+			len = RN_UNIX_MAXFDS - nbfds;
+		}
+		memcpy(fds + nbfds, CMSG_DATA(cmsg), sizeof(int) * len);
+		nbfds += len;
+	}
+	if ((msg.msg_flags & MSG_CTRUNC) || nbfds > count) {
+		/* Descriptors were dropped by the kernel or cannot be returned */
+		for (i = 0; i < nbfds; i++) {
+			close(fds[i]);
+		}
+		rn_error_set(EMSGSIZE);
+		return -1;
+	}
+	received = 0;
+	for (i = 0; i < nbfds; i++) {
+		if ((sockets[received] = rn_unix_wrapfd(socket->node.sched, fds[i])) != NULL) {
+			received++;
+		} else {
+			close(fds[i]);
+		}
+	}
+	return received;
+}
@@ -146,6 +146,8 @@ int rn_http_easy_server(rn_sched_t *sched, rn_addr_t *dst, rn_http_route_t *rout
 	if (server == NULL) {
 		return -1;
 	}
+	/* Response headers and body are sent in full segments */
+	rn_socket_setopt(server, RN_SOCKET_AUTOCORK, 1);
 	context = malloc(sizeof(*context));
 	if (context == NULL) {
 		return -1;
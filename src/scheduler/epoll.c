@@ -25,6 +25,9 @@ int rn_epoll_init(rn_sched_t *sched)
 	sched->epoll.fd = epoll_create(42); /* Size does not matter any more ;) */
 	XASSERT(sched->epoll.fd != -1, -1);
 	sched->epoll.curevent = -1;
+#ifdef HAS_EPOLL_PWAIT2
+	sched->epoll.highres = true;
+#endif /* !HAS_EPOLL_PWAIT2 */
 	if (sigaction(SIGPIPE, &(struct sigaction){ .sa_handler = SIG_IGN }, NULL) != 0) {
 		close(sched->epoll.fd);
 		return -1;
@@ -116,22 +119,61 @@ int rn_epoll_remove(rn_sched_node_t *node)
 	return 0;
 }
 
+/**
+ * Waits for events using the most precise timeout available.
+ * epoll_pwait2 takes a nanosecond timeout. If the running kernel
+ * does not provide it, this falls back to epoll_wait and a millisecond timeout.
+ *
+ * @param sched Pointer to the scheduler to use.
+ * @param timeout Maximum time to wait in microseconds (-1 for no timeout)
+ *
+ * @return Number of events received, or -1 if an error occurs.
+ */
+static int rn_epoll_wait(rn_sched_t *sched, int64_t timeout)
+{
+#ifdef HAS_EPOLL_PWAIT2
+	int nbevents;
+	struct timespec ts;
+
+	if (likely(sched->epoll.highres)) {
+		if (timeout >= 0) {
+			ts.tv_sec = timeout / 1000000;
+			ts.tv_nsec = (timeout % 1000000) * 1000;
+		}
+		nbevents = epoll_pwait2(sched->epoll.fd, sched->epoll.events, RN_EPOLL_MAX_EVENTS, (timeout >= 0 ? &ts : NULL), NULL);
+		if (likely(nbevents != -1 || errno != ENOSYS)) {
+			return nbevents;
+		}
+		sched->epoll.highres = false;
+	}
+#endif /* !HAS_EPOLL_PWAIT2 */
+	if (timeout > 0) {
+		/* Rounded up, a shorter timeout would poll until the deadline */
+		timeout = (timeout + 999) / 1000;
+		if (timeout > INT_MAX) {
+			timeout = INT_MAX;
+		}
+	}
+	return epoll_wait(sched->epoll.fd, sched->epoll.events, RN_EPOLL_MAX_EVENTS, timeout);
+}
+
 /**
  * Start polling. It calls epoll_wait.
  *
  * @param sched Pointer to the scheduler to use.
- * @param timeout Maximum time to wait in milliseconds (-1 for no timeout)
+ * @param timeout Maximum time to wait in microseconds (-1 for no timeout)
  *
  * @return 0 if succeeds, else -1.
  */
-int rn_epoll_poll(rn_sched_t *sched, int timeout)
+int rn_epoll_poll(rn_sched_t *sched, int64_t timeout)
 {
 	int nbevents;
 	struct epoll_event *event;
 
 	XASSERT(sched != NULL, -1);
 
-	nbevents = epoll_wait(sched->epoll.fd, sched->epoll.events, RN_EPOLL_MAX_EVENTS, timeout);
+	nbevents = rn_epoll_wait(sched, timeout);
+	gettimeofday(&sched->awake, NULL);
 	if (unlikely(nbevents == -1)) {
 		/* We don't want to raise an error in this case */
 		return 0;
@@ -145,7 +187,10 @@ int rn_epoll_poll(rn_sched_t *sched, int timeout)
 		if (event->data.ptr != NULL && (event->events & EPOLLOUT) == EPOLLOUT) {
 			rn_scheduler_wakeup(event->data.ptr, RN_MODE_OUT, 0);
 		}
-		if (event->data.ptr != NULL && (((event->events & EPOLLERR) == EPOLLERR || (event->events & EPOLLHUP) == EPOLLHUP))) {
+		if (event->data.ptr != NULL && (event->events & (EPOLLERR | EPOLLHUP)) == EPOLLERR && ((rn_sched_node_t *) event->data.ptr)->errqueue) {
+			/* Error queue notification (e.g. zero-copy completion), readers will get it */
+			rn_scheduler_wakeup(event->data.ptr, RN_MODE_IN, 0);
+		} else if (event->data.ptr != NULL && (((event->events & EPOLLERR) == EPOLLERR || (event->events & EPOLLHUP) == EPOLLHUP))) {
 			rn_scheduler_wakeup(event->data.ptr, RN_MODE_NONE, ECONNRESET);
 		}
 	}
@@ -0,0 +1,288 @@
+/**
+ * @file   fd.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Generic file descriptor management
+ *
+ *
+ */
+
+#include "rinoo/scheduler/module.h"
+
+/**
+ * Wraps a file descriptor to be used by tasks of a scheduler.
+ * The file descriptor is set in non-blocking mode and will be
+ * closed by rn_fd_destroy.
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param fd File descriptor to wrap
+ *
+ * @return Pointer to the new rn_fd_t, or NULL if an error occurs
+ */
+rn_fd_t *rn_fd(rn_sched_t *sched, int fd)
+{
+	int enabled;
+	rn_fd_t *new;
+
+	XASSERT(sched != NULL, NULL);
+	XASSERT(fd >= 0, NULL);
+
+	enabled = 1;
+	if (unlikely(ioctl(fd, FIONBIO, &enabled) == -1)) {
+		rn_error_set(errno);
+		return NULL;
+	}
+	new = calloc(1, sizeof(*new));
+	if (unlikely(new == NULL)) {
+		rn_error_set(errno);
+		return NULL;
+	}
+	new->node.fd = fd;
+	new->node.sched = sched;
+	return new;
+}
+
+/**
+ * Removes a file descriptor from its scheduler, closes it and frees memory.
+ *
+ * @param fd Pointer to the rn_fd_t to destroy
+ */
+void rn_fd_destroy(rn_fd_t *fd)
+{
+	XASSERTN(fd != NULL);
+
+	rn_scheduler_remove(&fd->node);
+	close(fd->node.fd);
+	free(fd);
+}
+
+/**
+ * Releases execution and waits for the file descriptor to be available for read operations.
+ *
+ * @param fd Pointer to the rn_fd_t to wait for
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_fd_waitin(rn_fd_t *fd)
+{
+	fd->io_calls = 0;
+	return rn_scheduler_waitfor(&fd->node, RN_MODE_IN);
+}
+
+/**
+ * Releases execution and waits for the file descriptor to be available for write operations.
+ *
+ * @param fd Pointer to the rn_fd_t to wait for
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_fd_waitout(rn_fd_t *fd)
+{
+	fd->io_calls = 0;
+	return rn_scheduler_waitfor(&fd->node, RN_MODE_OUT);
+}
+
+/**
+ * Increments internal io counter and releases the task if too many io operations
+ * have been done consecutively.
+ *
+ * @param fd Pointer to the rn_fd_t to use
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+static int rn_fd_waitio(rn_fd_t *fd)
+{
+	fd->io_calls++;
+	if (fd->io_calls > RN_FD_MAX_IO_CALLS) {
+		fd->io_calls = 0;
+		if (rn_task_pause(fd->node.sched) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Replacement to the read(2) syscall for a wrapped file descriptor.
+ * This function waits for the file descriptor to be available for read operations and calls the read(2) syscall.
+ *
+ * @param fd Pointer to the rn_fd_t to read
+ * @param buf Buffer where to store the information read
+ * @param count Buffer size
+ *
+ * @return The number of bytes read on success, 0 on end of file, or -1 if an error occurs
+ */
+ssize_t rn_fd_read(rn_fd_t *fd, void *buf, size_t count)
+{
+	ssize_t ret;
+
+	if (rn_fd_waitio(fd) != 0) {
+		return -1;
+	}
+	while ((ret = read(fd->node.fd, buf, count)) < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			rn_error_set(errno);
+			return -1;
+		}
+		if (rn_fd_waitin(fd) != 0) {
+			return -1;
+		}
+	}
+	return ret;
+}
+
+/**
+ * Replacement to the write(2) syscall for a wrapped file descriptor.
+ * This function waits for the file descriptor to be available for write operations and calls the write(2) syscall.
+ *
+ * @param fd Pointer to the rn_fd_t to write to
+ * @param buf Buffer which stores the information to write
+ * @param count Buffer size
+ *
+ * @return The number of bytes written on success or -1 if an error occurs
+ */
+ssize_t rn_fd_write(rn_fd_t *fd, const void *buf, size_t count)
+{
+	size_t sent;
+	ssize_t ret;
+
+	sent = count;
+	while (count > 0) {
+		if (rn_fd_waitio(fd) != 0) {
+			return -1;
+		}
+		ret = write(fd->node.fd, buf, count);
+		if (ret == 0) {
+			return -1;
+		} else if (ret < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				rn_error_set(errno);
+				return -1;
+			}
+			if (rn_fd_waitout(fd) != 0) {
+				return -1;
+			}
+			ret = 0;
+		}
+		count -= ret;
+		buf += ret;
+	}
+	return sent;
+}
+
+/**
+ * Creates an eventfd to notify tasks of a scheduler.
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param initval Initial counter value
+ *
+ * @return Pointer to the new rn_fd_t, or NULL if an error occurs
+ */
+rn_fd_t *rn_eventfd(rn_sched_t *sched, unsigned int initval)
+{
+	int fd;
+	rn_fd_t *new;
+
+	fd = eventfd(initval, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (unlikely(fd < 0)) {
+		rn_error_set(errno);
+		return NULL;
+	}
+	new = rn_fd(sched, fd);
+	if (unlikely(new == NULL)) {
+		close(fd);
+		return NULL;
+	}
+	return new;
+}
+
+/**
+ * Waits for an eventfd to be notified and reads its counter.
+ *
+ * @param fd Pointer to the eventfd
+ * @param value Pointer where to store the counter value
+ *
+ * @return 0 on success, or -1 if an error occurs
+ */
+int rn_eventfd_read(rn_fd_t *fd, uint64_t *value)
+{
+	if (rn_fd_read(fd, value, sizeof(*value)) != sizeof(*value)) {
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Adds a value to an eventfd counter, waking up the task reading it.
+ * Unlike other rn_fd functions, this can be called from any thread:
+ * it only waits for the eventfd when called from the scheduler owning it.
+ *
+ * @param fd Pointer to the eventfd
+ * @param value Value to add
+ *
+ * @return 0 on success, or -1 if an error occurs
+ */
+int rn_eventfd_write(rn_fd_t *fd, uint64_t value)
+{
+	while (write(fd->node.fd, &value, sizeof(value)) != sizeof(value)) {
+		if (errno != EAGAIN || rn_scheduler_self() != fd->node.sched) {
+			rn_error_set(errno);
+			return -1;
+		}
+		if (rn_fd_waitout(fd) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Creates a signalfd so tasks can handle signals.
+ * Signals in mask get blocked in the calling thread. As signals
+ * are delivered to any thread which does not block them, this should be
+ * called before spawning threads (spawns inherit the signal mask).
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param mask Set of signals to handle
+ *
+ * @return Pointer to the new rn_fd_t, or NULL if an error occurs
+ */
+rn_fd_t *rn_signalfd(rn_sched_t *sched, const sigset_t *mask)
+{
+	int fd;
+	rn_fd_t *new;
+
+	XASSERT(mask != NULL, NULL);
+
+	if (pthread_sigmask(SIG_BLOCK, mask, NULL) != 0) {
+		return NULL;
+	}
+	fd = signalfd(-1, mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (unlikely(fd < 0)) {
+		rn_error_set(errno);
+		return NULL;
+	}
+	new = rn_fd(sched, fd);
+	if (unlikely(new == NULL)) {
+		close(fd);
+		return NULL;
+	}
+	return new;
+}
+
+/**
+ * Waits for a signal to be received on a signalfd.
+ *
+ * @param fd Pointer to the signalfd
+ * @param info Pointer where to store signal information
+ *
+ * @return 0 on success, or -1 if an error occurs
+ */
+int rn_signalfd_read(rn_fd_t *fd, struct signalfd_siginfo *info)
+{
+	if (rn_fd_read(fd, info, sizeof(*info)) != sizeof(*info)) {
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file   pipe.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Per-scheduler pool of pipes
+ *
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+
+#include "rinoo/scheduler/module.h"
+
+/**
+ * Gets a pipe from the scheduler pool, or creates a new one if the pool is empty.
+ * Pipes are non-blocking and are meant to be used by one task at a time,
+ * typically as an intermediate buffer for splice(2).
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param fds Array where to store the read and write ends of the pipe
+ *
+ * @return 0 on success, or -1 if an error occurs
+ */
+int rn_pipe_get(rn_sched_t *sched, int fds[2])
+{
+	XASSERT(sched != NULL, -1);
+
+	if (sched->pipes.count > 0) {
+		sched->pipes.count--;
+		fds[0] = sched->pipes.fds[sched->pipes.count][0];
+		fds[1] = sched->pipes.fds[sched->pipes.count][1];
+		return 0;
+	}
+	if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+		rn_error_set(errno);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Gives a pipe back to the scheduler pool.
+ * Pipes still holding data, or exceeding the pool size, are closed.
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param fds Read and write ends of the pipe
+ */
+void rn_pipe_release(rn_sched_t *sched, int fds[2])
+{
+	int pending;
+
+	XASSERTN(sched != NULL);
+
+	if (sched->pipes.count < RN_PIPE_POOL_SIZE && ioctl(fds[0], FIONREAD, &pending) == 0 && pending == 0) {
+		sched->pipes.fds[sched->pipes.count][0] = fds[0];
+		sched->pipes.fds[sched->pipes.count][1] = fds[1];
+		sched->pipes.count++;
+		return;
+	}
+	close(fds[0]);
+	close(fds[1]);
+}
+
+/**
+ * Closes all pipes of a scheduler pool.
+ *
+ * @param sched Pointer to the scheduler to use
+ */
+void rn_pipe_destroy(rn_sched_t *sched)
+{
+	XASSERTN(sched != NULL);
+
+	while (sched->pipes.count > 0) {
+		sched->pipes.count--;
+		close(sched->pipes.fds[sched->pipes.count][0]);
+		close(sched->pipes.fds[sched->pipes.count][1]);
+	}
+}
@@ -0,0 +1,370 @@
+/**
+ * @file   profiler.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  Task sampling profiler
+ *
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <ucontext.h>
+
+#include "rinoo/scheduler/module.h"
+
+#ifndef sigev_notify_thread_id
+# define sigev_notify_thread_id	_sigev_un._tid
+#endif
+
+/* SIGPROF action is process wide, it is shared by running profilers */
+static pthread_mutex_t rn_profiler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t rn_profiler_users = 0;
+static struct sigaction rn_profiler_oldaction;
+
+/**
+ * Walks the frame pointer chain of the interrupted code.
+ * Frames are only followed while they stay in the stack being used,
+ * which is the task stack, or the thread stack for the scheduler itself.
+ * Without -fno-omit-frame-pointer, only the first frames are reliable.
+ *
+ * @param profiler Pointer to the profiler
+ * @param task Pointer to the interrupted task
+ * @param ucontext Pointer to the interrupted context
+ * @param sample Pointer to the sample to fill
+ */
+static void rn_profiler_unwind(rn_profiler_t *profiler, rn_task_t *task, ucontext_t *ucontext, rn_profiler_sample_t *sample)
+{
+#ifdef __x86_64__
+	void **fp;
+	void **next;
+	char *low;
+	char *high;
+
+	if (task == &task->sched->driver.main) {
+		low = profiler->stack_low;
+		high = profiler->stack_high;
+	} else {
+		low = task->stack;
+		high = task->stack + sizeof(task->stack);
+	}
+	sample->frames[0] = (void *) ucontext->uc_mcontext.gregs[REG_RIP];
+	sample->depth = 1;
+	fp = (void **) ucontext->uc_mcontext.gregs[REG_RBP];
+	while (sample->depth < RN_PROFILER_DEPTH) {
+		if ((char *) fp < low || (char *) (fp + 2) > high || ((uintptr_t) fp & (sizeof(*fp) - 1)) != 0) {
+			break;
+		}
+		sample->frames[sample->depth++] = fp[1];
+		next = fp[0];
+		if (next <= fp) {
+			break;
+		}
+		fp = next;
+	}
+#else
+	(void) profiler;
+	(void) task;
+	(void) ucontext;
+	sample->depth = 0;
+#endif /* !__x86_64__ */
+}
+
+/**
+ * SIGPROF handler. Records a sample for the task running on this thread.
+ *
+ * @param signum Signal number
+ * @param info Signal information
+ * @param ucontext Interrupted context
+ */
+static void rn_profiler_handler(int unused(signum), siginfo_t *unused(info), void *ucontext)
+{
+	int error;
+	rn_task_t *task;
+	rn_profiler_t *profiler;
+	rn_profiler_sample_t *sample;
+
+	task = rn_task_self();
+	if (task == NULL || task->sched->profiler == NULL || task->sched->profiler->running == false) {
+		return;
+	}
+	error = errno;
+	profiler = task->sched->profiler;
+	if (profiler->count >= RN_PROFILER_SAMPLES) {
+		profiler->dropped++;
+	} else {
+		sample = &profiler->samples[profiler->count];
+		sample->function = task->function;
+		rn_profiler_unwind(profiler, task, ucontext, sample);
+		profiler->count++;
+	}
+	errno = error;
+}
+
+/**
+ * Installs the SIGPROF handler, saving the previous action for the first profiler.
+ *
+ * @return 0 on success, or -1 if an error occurs
+ */
+static int rn_profiler_sigaction(void)
+{
+	int ret;
+	struct sigaction sa;
+
+	ret = 0;
+	pthread_mutex_lock(&rn_profiler_mutex);
+	if (rn_profiler_users == 0) {
+		memset(&sa, 0, sizeof(sa));
+		sa.sa_sigaction = rn_profiler_handler;
+		sa.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset(&sa.sa_mask);
+		ret = sigaction(SIGPROF, &sa, &rn_profiler_oldaction);
+		if (ret != 0) {
+			rn_error_set(errno);
+		}
+	}
+	if (ret == 0) {
+		rn_profiler_users++;
+	}
+	pthread_mutex_unlock(&rn_profiler_mutex);
+	return ret;
+}
+
+/**
+ * Restores the previous SIGPROF action once the last profiler is stopped.
+ */
+static void rn_profiler_sigrestore(void)
+{
+	pthread_mutex_lock(&rn_profiler_mutex);
+	if (--rn_profiler_users == 0) {
+		sigaction(SIGPROF, &rn_profiler_oldaction, NULL);
+	}
+	pthread_mutex_unlock(&rn_profiler_mutex);
+}
+
+/**
+ * Starts sampling tasks of a scheduler.
+ * This must be called from the thread running the scheduler
+ * (typically from one of its tasks), as samples are taken on
+ * that thread CPU time. Previous samples are discarded.
+ *
+ * @param sched Pointer to the scheduler to profile
+ * @param hz Sampling frequency
+ *
+ * @return 0 on success, or -1 if an error occurs
+ */
+int rn_profiler_start(rn_sched_t *sched, uint32_t hz)
+{
+	size_t size;
+	pthread_attr_t attr;
+	struct sigevent sev;
+	struct itimerspec its;
+	rn_profiler_t *profiler;
+
+	XASSERT(sched != NULL, -1);
+	XASSERT(hz > 0 && hz <= 1000000, -1);
+
+	if (sched->profiler == NULL) {
+		profiler = calloc(1, sizeof(*profiler));
+		if (unlikely(profiler == NULL)) {
+			rn_error_set(errno);
+			return -1;
+		}
+		sched->profiler = profiler;
+	}
+	profiler = sched->profiler;
+	if (profiler->running == true) {
+		rn_error_set(EALREADY);
+		return -1;
+	}
+	if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+		return -1;
+	}
+	if (pthread_attr_getstack(&attr, (void **) &profiler->stack_low, &size) != 0) {
+		pthread_attr_destroy(&attr);
+		return -1;
+	}
+	pthread_attr_destroy(&attr);
+	profiler->stack_high = profiler->stack_low + size;
+	profiler->count = 0;
+	profiler->dropped = 0;
+
+	if (rn_profiler_sigaction() != 0) {
+		return -1;
+	}
+	memset(&sev, 0, sizeof(sev));
+	sev.sigev_notify = SIGEV_THREAD_ID;
+	sev.sigev_signo = SIGPROF;
+	sev.sigev_notify_thread_id = gettid();
+	if (timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &profiler->timer) != 0) {
+		rn_error_set(errno);
+		rn_profiler_sigrestore();
+		return -1;
+	}
+	its.it_interval.tv_sec = (1000000000 / hz) / 1000000000;
+	its.it_interval.tv_nsec = (1000000000 / hz) % 1000000000;
+	its.it_value = its.it_interval;
+	profiler->running = true;
+	if (timer_settime(profiler->timer, 0, &its, NULL) != 0) {
+		rn_error_set(errno);
+		profiler->running = false;
+		timer_delete(profiler->timer);
+		rn_profiler_sigrestore();
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Stops sampling tasks of a scheduler.
+ * Samples are kept until the next call to rn_profiler_start.
+ * The previous SIGPROF action is restored when no other scheduler is profiled.
+ *
+ * @param sched Pointer to the scheduler
+ *
+ * @return 0 on success, or -1 if the profiler is not running
+ */
+int rn_profiler_stop(rn_sched_t *sched)
+{
+	sigset_t set;
+	sigset_t old;
+
+	XASSERT(sched != NULL, -1);
+
+	if (sched->profiler == NULL || sched->profiler->running == false) {
+		return -1;
+	}
+	/* A signal raised before the timer is deleted must not reach the handler afterwards */
+	sigemptyset(&set);
+	sigaddset(&set, SIGPROF);
+	pthread_sigmask(SIG_BLOCK, &set, &old);
+	sched->profiler->running = false;
+	timer_delete(sched->profiler->timer);
+	while (sigtimedwait(&set, NULL, &(struct timespec){ 0, 0 }) == SIGPROF) {
+		/* Pending signal discarded */
+	}
+	rn_profiler_sigrestore();
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	return 0;
+}
+
+/**
+ * Stops sampling and frees profiler memory.
+ *
+ * @param sched Pointer to the scheduler
+ */
+void rn_profiler_destroy(rn_sched_t *sched)
+{
+	rn_profiler_t *profiler;
+
+	XASSERTN(sched != NULL);
+
+	if (sched->profiler == NULL) {
+		return;
+	}
+	rn_profiler_stop(sched);
+	profiler = sched->profiler;
+	sched->profiler = NULL;
+	free(profiler);
+}
+
+/**
+ * Sample comparison function used to group identical stacks.
+ *
+ * @param ptr1 Pointer to the first sample
+ * @param ptr2 Pointer to the second sample
+ *
+ * @return An integer less than, equal to, or greater than zero if ptr1 is lower, equal or greater than ptr2
+ */
+static int rn_profiler_cmp(const void *ptr1, const void *ptr2)
+{
+	const rn_profiler_sample_t *sample1 = ptr1;
+	const rn_profiler_sample_t *sample2 = ptr2;
+
+	if (sample1->function != sample2->function) {
+		return ((uintptr_t) sample1->function < (uintptr_t) sample2->function ? -1 : 1);
+	}
+	if (sample1->depth != sample2->depth) {
+		return (sample1->depth < sample2->depth ? -1 : 1);
+	}
+	return memcmp(sample1->frames, sample2->frames, sample1->depth * sizeof(*sample1->frames));
+}
+
+/**
+ * Prints a symbol name for an address.
+ * Symbols are resolved with dladdr, executables need to be linked
+ * with -rdynamic to get their function names.
+ *
+ * @param output Output stream
+ * @param addr Address to resolve
+ */
+static void rn_profiler_symbol(FILE *output, void *addr)
+{
+	Dl_info info;
+	const char *name;
+
+	if (dladdr(addr, &info) != 0) {
+		if (info.dli_sname != NULL) {
+			fputs(info.dli_sname, output);
+			return;
+		}
+		if (info.dli_fname != NULL) {
+			name = strrchr(info.dli_fname, '/');
+			fprintf(output, "%s+0x%lx", (name != NULL ? name + 1 : info.dli_fname), (uintptr_t) addr - (uintptr_t) info.dli_fbase);
+			return;
+		}
+	}
+	fprintf(output, "0x%lx", (uintptr_t) addr);
+}
+
+/**
+ * Writes samples as collapsed stacks, one line per distinct stack
+ * followed by its number of samples, as expected by flamegraph.pl.
+ * Each stack starts with the task entry function, or "scheduler"
+ * for samples taken outside of tasks. The profiler must be stopped.
+ *
+ * @param sched Pointer to the scheduler
+ * @param output Output stream
+ *
+ * @return Number of samples written, or -1 if an error occurs
+ */
+int rn_profiler_dump(rn_sched_t *sched, FILE *output)
+{
+	uint32_t i;
+	uint32_t j;
+	uint32_t count;
+	rn_profiler_t *profiler;
+	rn_profiler_sample_t *sample;
+
+	XASSERT(sched != NULL, -1);
+	XASSERT(output != NULL, -1);
+
+	profiler = sched->profiler;
+	if (profiler == NULL || profiler->running == true) {
+		rn_error_set(EINVAL);
+		return -1;
+	}
+	qsort(profiler->samples, profiler->count, sizeof(*profiler->samples), rn_profiler_cmp);
+	for (i = 0; i < profiler->count; i += count) {
+		sample = &profiler->samples[i];
+		for (count = 1; i + count < profiler->count; count++) {
+			if (rn_profiler_cmp(sample, &profiler->samples[i + count]) != 0) {
+				break;
+			}
+		}
+		if (sample->function != NULL) {
+			fputs("task:", output);
+			rn_profiler_symbol(output, (void *) sample->function);
+		} else {
+			fputs("scheduler", output);
+		}
+		for (j = sample->depth; j > 0; j--) {
+			fputc(';', output);
+			rn_profiler_symbol(output, sample->frames[j - 1]);
+		}
+		fprintf(output, " %u\n", count);
+	}
+	return profiler->count;
+}
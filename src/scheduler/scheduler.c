@@ -37,6 +37,7 @@ rn_sched_t *rn_scheduler(void)
 		return NULL;
 	}
 	gettimeofday(&sched->clock, NULL);
+	sched->awake = sched->clock;
 	return sched;
 }
 
@@ -68,6 +69,8 @@ void rn_scheduler_destroy(rn_sched_t *sched)
 	rn_list_flush(&sched->nodes, rn_sched_cancel_task);
 	rn_task_driver_destroy(sched);
 	rn_epoll_destroy(sched);
+	rn_pipe_destroy(sched);
+	rn_profiler_destroy(sched);
 	free(sched);
 }
 
@@ -88,6 +91,95 @@ rn_sched_t *rn_scheduler_self(void)
 	return task->sched;
 }
 
+/**
+ * Gets the current time of a scheduler.
+ * Tasks resumed by an I/O event run with a clock taken before polling,
+ * the time epoll returned is used instead when it is more recent.
+ *
+ * @param sched Pointer to the scheduler
+ * @param now Pointer where to store the current time
+ */
+void rn_scheduler_now(rn_sched_t *sched, struct timeval *now)
+{
+	*now = (timercmp(&sched->awake, &sched->clock, >) ? sched->awake : sched->clock);
+}
+
+/**
+ * Releases the task waiting on a node until the node deadline.
+ * The wait ends at the earliest of the mode timeout (started now) and the
+ * end of the idle period, unless the task is already scheduled earlier
+ * (see rn_socket_timeout). When the idle period has been extended by an
+ * event in the other direction, the task goes back to waiting.
+ *
+ * @param node Scheduler node to wait for
+ * @param mode Mode waited for
+ *
+ * @return 0 on success, or -1 if an error occurs
+ */
+static int rn_scheduler_waitdeadline(rn_sched_node_t *node, rn_sched_mode_t mode)
+{
+	int ret;
+	bool scheduled;
+	uint32_t timeout;
+	struct timeval tv;
+	struct timeval now;
+	struct timeval limit;
+	struct timeval saved;
+	struct timeval toadd;
+	rn_task_t *task = node->task;
+	rn_sched_t *sched = node->sched;
+
+	rn_scheduler_now(sched, &now);
+	timeout = (mode == RN_MODE_IN ? node->deadline.in : node->deadline.out);
+	if (timeout != 0) {
+		toadd.tv_sec = timeout / 1000;
+		toadd.tv_usec = (timeout % 1000) * 1000;
+		timeradd(&now, &toadd, &limit);
+	}
+	while (1) {
+		if (node->deadline.idle != 0) {
+			toadd.tv_sec = node->deadline.idle / 1000;
+			toadd.tv_usec = (node->deadline.idle % 1000) * 1000;
+			timeradd(&node->deadline.active, &toadd, &tv);
+			if (timeout != 0 && timercmp(&limit, &tv, <)) {
+				tv = limit;
+			}
+		} else if (timeout != 0) {
+			tv = limit;
+		} else {
+			return rn_task_release(sched);
+		}
+		scheduled = task->scheduled;
+		saved = task->tv;
+		if (scheduled && timercmp(&saved, &tv, <=)) {
+			return rn_task_release(sched);
+		}
+		if (rn_task_schedule(task, &tv) != 0) {
+			return -1;
+		}
+		ret = rn_task_release(sched);
+		rn_scheduler_now(sched, &now);
+		if (scheduled && timercmp(&saved, &now, >)) {
+			rn_task_schedule(task, &saved);
+		} else {
+			rn_task_unschedule(task);
+		}
+		if (ret != 0 || node->error != 0 || rn_mode_received(node, mode) || sched->stop) {
+			return ret;
+		}
+		if ((scheduled && timercmp(&saved, &now, <=)) || (timeout != 0 && timercmp(&limit, &now, <=))) {
+			return ret;
+		}
+		if (node->deadline.idle == 0) {
+			return ret;
+		}
+		timeradd(&node->deadline.active, &toadd, &tv);
+		if (timercmp(&tv, &now, <=)) {
+			return ret;
+		}
+	}
+}
+
 /**
  * Register a file descriptor in the scheduler and wait for IO.
  *
@@ -138,7 +230,11 @@ int rn_scheduler_waitfor(rn_sched_node_t *node, rn_sched_mode_t mode)
 		node->sched->nbpending--;
 		return 0;
 	}
-	if (rn_task_release(node->sched) != 0 && node->error == 0) {
+	if (unlikely(node->deadline.in != 0 || node->deadline.out != 0 || node->deadline.idle != 0)) {
+		if (rn_scheduler_waitdeadline(node, mode) != 0 && node->error == 0) {
+			node->error = rn_error;
+		}
+	} else if (rn_task_release(node->sched) != 0 && node->error == 0) {
 		node->error = rn_error;
 	}
 	node->sched->nbpending--;
@@ -160,6 +256,32 @@ int rn_scheduler_waitfor(rn_sched_node_t *node, rn_sched_mode_t mode)
 	return 0;
 }
 
+/**
+ * Sets deadlines of a scheduler node.
+ * A wait for input (resp. output) fails with ETIMEDOUT after in (resp. out)
+ * milliseconds. Independently, any wait fails once no I/O event has been
+ * received on the node for idle milliseconds, like a keep-alive timeout.
+ * Deadlines are enforced with the task timers, only while a task waits.
+ *
+ * @param node Scheduler node
+ * @param in Input timeout in milliseconds, 0 to disable
+ * @param out Output timeout in milliseconds, 0 to disable
+ * @param idle Idle timeout in milliseconds, 0 to disable
+ *
+ * @return 0 on success, otherwise -1
+ */
+int rn_scheduler_deadline(rn_sched_node_t *node, uint32_t in, uint32_t out, uint32_t idle)
+{
+	XASSERT(node != NULL, -1);
+	XASSERT(node->sched != NULL, -1);
+
+	node->deadline.in = in;
+	node->deadline.out = out;
+	node->deadline.idle = idle;
+	rn_scheduler_now(node->sched, &node->deadline.active);
+	return 0;
+}
+
 /**
  * Unregister a file descriptor from the scheduler.
  *
@@ -176,6 +298,8 @@ int rn_scheduler_remove(rn_sched_node_t *node)
 	if (rn_epoll_remove(node) != 0) {
 		return -1;
 	}
+	/* A later wait registers the node again */
+	node->modes = RN_MODE_NONE;
 	node->task = NULL;
 	return 0;
 }
@@ -194,6 +318,9 @@ void rn_scheduler_wakeup(rn_sched_node_t *node, rn_sched_mode_t mode, int error)
 		node->error = error;
 	}
 	rn_mode_received_set(node, mode);
+	if (node->deadline.idle != 0) {
+		node->deadline.active = node->sched->awake;
+	}
 	if (node->task == NULL || node->task == &node->sched->driver.main) {
 		return;
 	}
@@ -239,11 +366,26 @@ static bool rn_sched_end(rn_sched_t *sched)
  */
 int rn_scheduler_poll(rn_sched_t *sched)
 {
-	int timeout;
+	uint32_t lag;
+	int64_t timeout;
+	struct timeval now;
+	struct timeval busy;
 
 	gettimeofday(&sched->clock, NULL);
 	timeout = rn_task_driver_run(sched);
 	if (!rn_sched_end(sched)) {
+		/* Loop lag is the time spent since epoll last returned */
+		gettimeofday(&now, NULL);
+		timersub(&now, &sched->awake, &busy);
+		if (busy.tv_sec < 0) {
+			lag = 0;
+		} else if (busy.tv_sec >= UINT32_MAX / 1000000) {
+			lag = UINT32_MAX;
+		} else {
+			lag = (busy.tv_sec * 1000000) + busy.tv_usec;
+		}
+		/* Read by dispatchers running on other threads */
+		__atomic_store_n(&sched->lag, lag, __ATOMIC_RELAXED);
 		return rn_epoll_poll(sched, timeout);
 	}
 	return 0;
@@ -268,3 +410,85 @@ void rn_scheduler_loop(rn_sched_t *sched)
 loop_stop:
 	rn_spawn_join(sched);
 }
+
+/**
+ * Sets admission control of a scheduler.
+ * When a scheduler is overloaded, that is when it runs more than max_tasks
+ * tasks or when its last loop iteration took more than max_lag microseconds,
+ * rn_socket_accept either stops accepting (RN_ADMISSION_PAUSE) or closes
+ * new connections right away (RN_ADMISSION_REJECT).
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param mode Admission mode
+ * @param max_tasks Maximum number of live tasks, 0 for no limit
+ * @param max_lag Maximum loop lag in microseconds, 0 for no limit
+ *
+ * @return 0 on success, otherwise -1
+ */
+int rn_scheduler_admission(rn_sched_t *sched, rn_admission_mode_t mode, uint32_t max_tasks, uint32_t max_lag)
+{
+	XASSERT(sched != NULL, -1);
+	XASSERT(mode <= RN_ADMISSION_REJECT, -1);
+
+	sched->admission.mode = mode;
+	sched->admission.max_tasks = max_tasks;
+	sched->admission.max_lag = max_lag;
+	return 0;
+}
+
+/**
+ * Checks whether a scheduler is over its admission limits.
+ *
+ * @param sched Pointer to the scheduler to check
+ *
+ * @return true if the scheduler is overloaded, otherwise false
+ */
+bool rn_scheduler_overloaded(rn_sched_t *sched)
+{
+	if (sched->admission.max_tasks > 0 && sched->driver.nbtasks > sched->admission.max_tasks) {
+		return true;
+	}
+	if (sched->admission.max_lag > 0 && sched->lag > sched->admission.max_lag) {
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Enables or disables I/O accounting of sockets run by a scheduler.
+ * Counters are kept per socket (see rn_socket_stats) and summed up per scheduler.
+ * When disabled, or when the library is built with RINOO_NO_STATS, sockets
+ * do not pay for accounting.
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param enabled Whether I/O accounting should be enabled
+ *
+ * @return 0 on success, otherwise -1 (ENOTSUP if built with RINOO_NO_STATS)
+ */
+int rn_scheduler_stats_enable(rn_sched_t *sched, bool enabled)
+{
+	XASSERT(sched != NULL, -1);
+
+#ifdef RINOO_NO_STATS
+	if (enabled) {
+		rn_error_set(ENOTSUP);
+		return -1;
+	}
+#endif
+	sched->stats.enabled = enabled;
+	return 0;
+}
+
+/**
+ * Gets I/O counters of all sockets run by a scheduler.
+ *
+ * @param sched Pointer to the scheduler to use
+ *
+ * @return Pointer to the scheduler counters
+ */
+const rn_stats_t *rn_scheduler_stats(rn_sched_t *sched)
+{
+	XASSERT(sched != NULL, NULL);
+
+	return &sched->stats.total;
+}
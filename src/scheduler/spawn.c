@@ -43,6 +43,7 @@ int rn_spawn(rn_sched_t *sched, int count)
 			return -1;
 		}
 		child->id = i + 1;
+		child->driver.slack = sched->driver.slack;
 		sched->spawns.thread[i].id = 0;
 		sched->spawns.thread[i].sched = child;
 	}
@@ -64,29 +64,39 @@ void rn_task_driver_destroy(rn_sched_t *sched)
 }
 
 /**
- * Runs pending tasks and returns time before next task (in ms).
+ * Runs pending tasks and returns time before next task (in us).
  * If no task is queued, -1 is returned.
  *
  * @param sched Pointer to the scheduler to use
  *
- * @return Time before next task in ms or -1 if no task is queued
+ * @return Time before next task in us or -1 if no task is queued
  */
-int rn_task_driver_run(rn_sched_t *sched)
+int64_t rn_task_driver_run(rn_sched_t *sched)
 {
+	bool wakeup;
 	rn_task_t *task;
 	struct timeval tv;
 	rn_rbtree_node_t *head;
 
 	XASSERT(sched != NULL, -1);
 
+	wakeup = false;
 	while ((head = rn_rbtree_head(&sched->driver.proc_tree)) != NULL) {
 		task = container_of(head, rn_task_t, proc_node);
 		if (timercmp(&task->tv, &sched->clock, <=)) {
+			if (timerisset(&task->tv)) {
+				/* Timers expiring in the same run share a single wakeup */
+				if (wakeup == false) {
+					sched->driver.stats.wakeups++;
+					wakeup = true;
+				}
+				sched->driver.stats.expired++;
+			}
 			rn_task_unschedule(task);
 			rn_task_resume(task);
 		} else {
 			timersub(&task->tv, &sched->clock, &tv);
-			return (tv.tv_sec * 1000) + (tv.tv_usec / 1000);
+			return ((int64_t) tv.tv_sec * 1000000) + tv.tv_usec;
 		}
 	}
 	return -1;
@@ -139,6 +149,37 @@ rn_task_t *rn_task_driver_getcurrent(rn_sched_t *sched)
 	return sched->driver.current;
 }
 
+/**
+ * Sets timer slack of a scheduler.
+ * Task deadlines are rounded up to a multiple of slack so that
+ * close timers expire together, in a single scheduler wakeup.
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param us Timer slack in microseconds, 0 to disable
+ */
+void rn_task_driver_slack(rn_sched_t *sched, uint32_t us)
+{
+	XASSERTN(sched != NULL);
+
+	sched->driver.slack = us;
+}
+
+/**
+ * Gets timer statistics of a scheduler.
+ * saved is the number of wakeups avoided by expiring timers together.
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param stats Pointer to the statistics structure to fill
+ */
+void rn_task_driver_stats(rn_sched_t *sched, rn_task_stats_t *stats)
+{
+	XASSERTN(sched != NULL);
+	XASSERTN(stats != NULL);
+
+	*stats = sched->driver.stats;
+	stats->saved = stats->expired - stats->wakeups;
+}
+
 /**
  * Create a new task.
  *
@@ -165,6 +206,9 @@ rn_task_t *rn_task(rn_sched_t *sched, rn_task_t *parent, void (*function)(void *
 	task->context.stack.sp = task->stack;
 	task->context.stack.size = sizeof(task->stack);
 	task->context.link = &parent->context;
+	task->function = function;
+	rn_list(&task->hooks, NULL);
+	sched->driver.nbtasks++;
 	memset(&task->tv, 0, sizeof(task->tv));
 	memset(&task->proc_node, 0, sizeof(task->proc_node));
 	fcontext(&task->context, function, arg);
@@ -179,17 +223,28 @@ rn_task_t *rn_task(rn_sched_t *sched, rn_task_t *parent, void (*function)(void *
 
 /**
  * Destroy a task.
+ * Hooks still registered are run a last time.
  *
  * @param task Pointer to the task to destroy
  */
 void rn_task_destroy(rn_task_t *task)
 {
+	rn_list_node_t *node;
+	rn_list_node_t *next;
+	rn_task_hook_t *hook;
+
 	XASSERTN(task != NULL);
 
+	for (node = task->hooks.head; node != NULL; node = next) {
+		next = node->next;
+		hook = container_of(node, rn_task_hook_t, node);
+		hook->func(hook);
+	}
 #ifdef RINOO_DEBUG
 	VALGRIND_STACK_DEREGISTER(task->valgrind_stackid);
 #endif /* !RINOO_DEBUG */
 	rn_task_unschedule(task);
+	task->sched->driver.nbtasks--;
 	free(task);
 }
 
@@ -274,8 +329,17 @@ int rn_task_resume(rn_task_t *task)
  */
 int rn_task_release(rn_sched_t *sched)
 {
+	rn_list_node_t *node;
+	rn_list_node_t *next;
+	rn_task_hook_t *hook;
+
 	XASSERT(sched != NULL, -1);
 
+	for (node = sched->driver.current->hooks.head; node != NULL; node = next) {
+		next = node->next;
+		hook = container_of(node, rn_task_hook_t, node);
+		hook->func(hook);
+	}
 	fcontext_swap(&sched->driver.current->context, &sched->driver.main.context);
 	if (sched->stop == true) {
 		rn_error_set(ECANCELED);
@@ -286,6 +350,7 @@ int rn_task_release(rn_sched_t *sched)
 
 /**
  * Schedule a task to be executed at specific time.
+ * If the scheduler has a timer slack, execution time is rounded up to it.
  *
  * @param task Pointer to the task to schedule
  * @param tv Pointer to a timeval representing the expected execution time
@@ -294,6 +359,9 @@ int rn_task_release(rn_sched_t *sched)
  */
 int rn_task_schedule(rn_task_t *task, struct timeval *tv)
 {
+	uint64_t usec;
+	uint32_t slack;
+
 	XASSERT(task != NULL, -1);
 	XASSERT(task->sched != NULL, -1);
 
@@ -303,6 +371,13 @@ int rn_task_schedule(rn_task_t *task, struct timeval *tv)
 	}
 	if (tv != NULL) {
 		task->tv = *tv;
+		slack = task->sched->driver.slack;
+		if (slack > 0 && timerisset(&task->tv)) {
+			usec = ((uint64_t) task->tv.tv_sec * 1000000) + task->tv.tv_usec;
+			usec = ((usec + slack - 1) / slack) * slack;
+			task->tv.tv_sec = usec / 1000000;
+			task->tv.tv_usec = usec % 1000000;
+		}
 	} else {
 		memset(&task->tv, 0, sizeof(task->tv));
 	}
@@ -342,17 +417,30 @@ int rn_task_unschedule(rn_task_t *task)
  * @return 0 on success or -1 if an error occurs
  */
 int rn_task_wait(rn_sched_t *sched, uint32_t ms)
+{
+	return rn_task_wait_us(sched, (uint64_t) ms * 1000);
+}
+
+/**
+ * Release a task for a given time, with microsecond precision.
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param us Release time in microseconds
+ *
+ * @return 0 on success or -1 if an error occurs
+ */
+int rn_task_wait_us(rn_sched_t *sched, uint64_t us)
 {
 	struct timeval res;
 	struct timeval toadd;
 
-	if (ms == 0) {
+	if (us == 0) {
 		if (rn_task_schedule(rn_task_driver_getcurrent(sched), NULL) != 0) {
 			return -1;
 		}
 	} else {
-		toadd.tv_sec = ms / 1000;
-		toadd.tv_usec = (ms % 1000) * 1000;
+		toadd.tv_sec = us / 1000000;
+		toadd.tv_usec = us % 1000000;
 		timeradd(&sched->clock, &toadd, &res);
 		if (rn_task_schedule(rn_task_driver_getcurrent(sched), &res) != 0) {
 			return -1;
@@ -361,6 +449,51 @@ int rn_task_wait(rn_sched_t *sched, uint32_t ms)
 	return rn_task_release(sched);
 }
 
+/**
+ * Release a task for a given time, keeping its current timer.
+ * Unlike rn_task_wait_us, a timer already set on the task (like a socket
+ * timeout) is restored afterwards, and wins if it expires first.
+ *
+ * @param sched Pointer to the scheduler to use
+ * @param us Release time in microseconds
+ *
+ * @return 0 on success or -1 if an error occurs (ETIMEDOUT if the task timer expired)
+ */
+int rn_task_delay_us(rn_sched_t *sched, uint64_t us)
+{
+	int ret;
+	bool scheduled;
+	struct timeval res;
+	struct timeval saved;
+	struct timeval toadd;
+	rn_task_t *task;
+
+	task = rn_task_driver_getcurrent(sched);
+	scheduled = task->scheduled;
+	saved = task->tv;
+	toadd.tv_sec = us / 1000000;
+	toadd.tv_usec = us % 1000000;
+	timeradd(&sched->clock, &toadd, &res);
+	if (scheduled && timercmp(&saved, &res, <=)) {
+		/* The task timer expires first */
+		if (rn_task_release(sched) != 0) {
+			return -1;
+		}
+		rn_error_set(ETIMEDOUT);
+		return -1;
+	}
+	if (rn_task_schedule(task, &res) != 0) {
+		return -1;
+	}
+	ret = rn_task_release(sched);
+	if (scheduled) {
+		rn_task_schedule(task, &saved);
+	} else {
+		rn_task_unschedule(task);
+	}
+	return ret;
+}
+
 /**
  * Release a task to be re-scheduled as soon as possible.
  * This can be called by a busy task to give processing back to the scheduler.
@@ -410,3 +543,36 @@ rn_task_t *rn_task_self(void)
 {
 	return current_task;
 }
+
+/**
+ * Registers a function to be called each time a task yields, and when it ends.
+ * Hooks run right before the task releases execution (or once it is over):
+ * they must not wait themselves (this would yield again).
+ *
+ * @param task Pointer to the task
+ * @param hook Pointer to the hook to register
+ * @param func Function to call
+ */
+void rn_task_hook(rn_task_t *task, rn_task_hook_t *hook, void (*func)(rn_task_hook_t *hook))
+{
+	XASSERTN(task != NULL);
+	XASSERTN(hook != NULL);
+	XASSERTN(func != NULL);
+
+	hook->func = func;
+	rn_list_put(&task->hooks, &hook->node);
+}
+
+/**
+ * Unregisters a task hook.
+ *
+ * @param task Pointer to the task
+ * @param hook Pointer to the hook to unregister
+ */
+void rn_task_unhook(rn_task_t *task, rn_task_hook_t *hook)
+{
+	XASSERTN(task != NULL);
+	XASSERTN(hook != NULL);
+
+	rn_list_remove(&task->hooks, &hook->node);
+}
@@ -0,0 +1,82 @@
+/**
+ * @file   rn_fd.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  rn_eventfd and rn_signalfd unit test
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBEVENTS	10
+
+static rn_fd_t *efd;
+static rn_fd_t *sfd;
+
+void reader_func(void *unused(arg))
+{
+	int i;
+	uint64_t value;
+
+	rn_log("%s start", __FUNCTION__);
+	for (i = 0; i < NBEVENTS; i++) {
+		XTEST(rn_eventfd_read(efd, &value) == 0);
+		XTEST(value == (uint64_t) i + 1);
+		rn_log("%s: received %lu", __FUNCTION__, value);
+	}
+	rn_log("%s end", __FUNCTION__);
+}
+
+void writer_func(void *sched)
+{
+	int i;
+
+	rn_log("%s start", __FUNCTION__);
+	for (i = 0; i < NBEVENTS; i++) {
+		XTEST(rn_eventfd_write(efd, i + 1) == 0);
+		rn_task_wait(sched, 1);
+	}
+	rn_log("%s end", __FUNCTION__);
+}
+
+void signal_func(void *unused(arg))
+{
+	struct signalfd_siginfo info;
+
+	rn_log("%s start", __FUNCTION__);
+	XTEST(kill(getpid(), SIGUSR1) == 0);
+	XTEST(rn_signalfd_read(sfd, &info) == 0);
+	XTEST(info.ssi_signo == SIGUSR1);
+	rn_log("%s end", __FUNCTION__);
+}
+
+/**
+ * Main function for this unit test
+ *
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	sigset_t mask;
+	rn_sched_t *sched;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	efd = rn_eventfd(sched, 0);
+	XTEST(efd != NULL);
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGUSR1);
+	sfd = rn_signalfd(sched, &mask);
+	XTEST(sfd != NULL);
+	XTEST(rn_task_start(sched, reader_func, NULL) == 0);
+	XTEST(rn_task_start(sched, writer_func, sched) == 0);
+	XTEST(rn_task_start(sched, signal_func, NULL) == 0);
+	rn_scheduler_loop(sched);
+	rn_fd_destroy(efd);
+	rn_fd_destroy(sfd);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
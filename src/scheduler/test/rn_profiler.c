@@ -0,0 +1,88 @@
+/**
+ * @file   rn_profiler.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  rn_profiler unit test
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define PROFILE_HZ	1000
+
+volatile int app_signals = 0;
+
+void app_handler(int unused(signum))
+{
+	app_signals++;
+}
+
+void busy_func(void *sched)
+{
+	int i;
+	volatile uint64_t sum;
+	struct timespec start;
+	struct timespec now;
+
+	XTEST(rn_profiler_start(sched, PROFILE_HZ) == 0);
+	XTEST(rn_profiler_start(sched, PROFILE_HZ) == -1);
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+	do {
+		for (i = 0, sum = 0; i < 100000; i++) {
+			sum += i;
+		}
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	} while ((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000 < 100);
+	XTEST(rn_profiler_stop(sched) == 0);
+	XTEST(app_signals == 0);
+}
+
+/**
+ * Main function for this unit test
+ *
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	int total;
+	int count;
+	FILE *output;
+	char line[4096];
+	char *ptr;
+	rn_sched_t *sched;
+	struct sigaction sa;
+
+	/* Application handler, replaced while profiling */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = app_handler;
+	XTEST(sigaction(SIGPROF, &sa, NULL) == 0);
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	XTEST(rn_task_start(sched, busy_func, sched) == 0);
+	rn_scheduler_loop(sched);
+	XTEST(sigaction(SIGPROF, NULL, &sa) == 0);
+	XTEST(sa.sa_handler == app_handler);
+	raise(SIGPROF);
+	XTEST(app_signals == 1);
+	output = tmpfile();
+	XTEST(output != NULL);
+	count = rn_profiler_dump(sched, output);
+	rn_log("Samples: %d", count);
+	XTEST(count > 0);
+	rewind(output);
+	total = 0;
+	while (fgets(line, sizeof(line), output) != NULL) {
+		rn_log("%s", line);
+		XTEST(strncmp(line, "task:", 5) == 0);
+		ptr = strrchr(line, ' ');
+		XTEST(ptr != NULL);
+		total += atoi(ptr + 1);
+	}
+	XTEST(total == count);
+	fclose(output);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
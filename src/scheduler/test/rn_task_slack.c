@@ -0,0 +1,50 @@
+/**
+ * @file   rn_task_slack.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  rn_task_driver_slack unit test
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#define NBTASKS		50
+#define SLACK		10000
+
+void task_func(void *arg)
+{
+	int i = (intptr_t) arg;
+
+	rn_task_wait(rn_scheduler_self(), (i % 5) + 1);
+}
+
+/**
+ * Main function for this unit test
+ *
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	int i;
+	rn_sched_t *sched;
+	rn_task_stats_t stats;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	rn_task_driver_slack(sched, SLACK);
+	for (i = 0; i < NBTASKS; i++) {
+		XTEST(rn_task_start(sched, task_func, (void *) (intptr_t) i) == 0);
+	}
+	rn_scheduler_loop(sched);
+	rn_task_driver_stats(sched, &stats);
+	rn_log("wakeups: %lu, expired: %lu, saved: %lu", stats.wakeups, stats.expired, stats.saved);
+	XTEST(stats.expired == NBTASKS);
+	/* Deadlines may straddle two slack buckets */
+	XTEST(stats.wakeups <= 2);
+	XTEST(stats.saved == stats.expired - stats.wakeups);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}
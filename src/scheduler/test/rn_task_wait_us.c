@@ -0,0 +1,111 @@
+/**
+ * @file   rn_task_wait_us.c
+ * @author Reginald Lips <reginald.l@gmail.com> - Copyright 2013
+ * @date   Wed Feb  1 18:56:27 2017
+ *
+ * @brief  rn_task_wait_us unit test
+ *
+ *
+ */
+
+#include "rinoo/rinoo.h"
+
+#ifdef RINOO_DEBUG
+#include <valgrind/valgrind.h>
+#define LATENCY			5000 + RUNNING_ON_VALGRIND * 110000
+#else
+#define LATENCY			5000
+#endif /* !RINOO_DEBUG */
+
+#define NBWAITS			20
+
+int check_time(struct timeval *prev, uint64_t us)
+{
+	uint64_t diffus;
+	struct timeval cur;
+	struct timeval diff;
+
+	if (gettimeofday(&cur, NULL) != 0) {
+		return -1;
+	}
+	timersub(&cur, prev, &diff);
+	diffus = diff.tv_sec * 1000000;
+	diffus += diff.tv_usec;
+	rn_log("Time diff found: %lu, expected: %lu - %u", diffus, us, LATENCY);
+	if (diffus > us) {
+		diffus = diffus - us;
+	} else {
+		diffus = us - diffus;
+	}
+	if (diffus > LATENCY) {
+		return -1;
+	}
+	*prev = cur;
+	return 0;
+}
+
+/**
+ * Gets the CPU time used by the current thread.
+ *
+ * @return CPU time in microseconds
+ */
+uint64_t cpu_time(void)
+{
+	struct timespec ts;
+
+	XTEST(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0);
+	return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void task_func(void *sched)
+{
+	int i;
+	uint64_t cpu;
+	uint64_t diffus;
+	struct timeval cur;
+	struct timeval prev;
+	struct timeval diff;
+
+	printf("%s start\n", __FUNCTION__);
+	XTEST(gettimeofday(&prev, NULL) == 0);
+	for (i = 0; i < NBWAITS; i++) {
+		rn_task_wait_us(sched, 250);
+	}
+	XTEST(check_time(&prev, NBWAITS * 250) == 0);
+	rn_task_wait_us(sched, 1500);
+	XTEST(check_time(&prev, 1500) == 0);
+	rn_log("millisecond epoll_wait fallback");
+	((rn_sched_t *) sched)->epoll.highres = false;
+	cpu = cpu_time();
+	XTEST(gettimeofday(&prev, NULL) == 0);
+	for (i = 0; i < NBWAITS; i++) {
+		rn_task_wait_us(sched, 250);
+	}
+	XTEST(gettimeofday(&cur, NULL) == 0);
+	timersub(&cur, &prev, &diff);
+	diffus = diff.tv_sec * 1000000 + diff.tv_usec;
+	cpu = cpu_time() - cpu;
+	rn_log("Time spent: %lu, cpu: %lu", diffus, cpu);
+	XTEST(diffus >= NBWAITS * 250);
+	/* Waits shorter than a millisecond must sleep, not poll until their deadline */
+	XTEST(cpu < diffus / 2);
+	printf("%s end\n", __FUNCTION__);
+}
+
+/**
+ * Main function for this unit test
+ *
+ *
+ * @return 0 if test passed
+ */
+int main()
+{
+	rn_sched_t *sched;
+
+	sched = rn_scheduler();
+	XTEST(sched != NULL);
+	XTEST(rn_task_start(sched, task_func, sched) == 0);
+	rn_scheduler_loop(sched);
+	rn_scheduler_destroy(sched);
+	XPASS();
+}